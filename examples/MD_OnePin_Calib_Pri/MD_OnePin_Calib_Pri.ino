@@ -0,0 +1,61 @@
+// MD_OnePin example PRI node
+//
+// Shows how to save the link I/O calibration in EEPROM so that begin()
+// does not need to measure it at every start. The first time the sketch
+// runs the calibration is measured and saved. After that the saved
+// values are used, giving a faster and repeatable start.
+//
+// Clear the EEPROM signature byte (or change CALIB_SIG) to measure again,
+// for example after changing the board or the core version.
+//
+#include <EEPROM.h>
+#include <MD_OnePin.h>
+
+const uint8_t COMMS_PIN = 8;    // pin used for communications
+
+// EEPROM layout: signature byte followed by the calibration
+const int CALIB_ADDR = 0;       // EEPROM address for the saved calibration
+const uint8_t CALIB_SIG = 0xa5; // marks a saved calibration
+
+MD_OnePin OP(COMMS_PIN);
+
+void setup(void)
+{
+  opCalib_t cal;
+
+  Serial.begin(57600);
+  Serial.print(F("\n[MD_OnePin Calibration]"));
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_RP2040)
+  EEPROM.begin(sizeof(cal) + 1);  // emulated EEPROM in flash
+#endif
+
+  if (EEPROM.read(CALIB_ADDR) == CALIB_SIG)
+  {
+    EEPROM.get(CALIB_ADDR + 1, cal);
+    OP.begin(cal);
+    Serial.print(F("\nSaved calibration"));
+  }
+  else
+  {
+    OP.begin();
+    cal = OP.getCalibration();
+    EEPROM.put(CALIB_ADDR + 1, cal);
+    EEPROM.write(CALIB_ADDR, CALIB_SIG);
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_RP2040)
+    EEPROM.commit();
+#endif
+    Serial.print(F("\nMeasured calibration"));
+  }
+
+  Serial.print(F("\nSwitch (us): "));
+  Serial.print(cal.switchTime);
+  Serial.print(F("\nWrite (us): "));
+  Serial.print(cal.writeTime);
+}
+
+void loop(void)
+{
+  OP.write(millis());
+  delay(1000);
+}
@@ -0,0 +1,51 @@
+// MD_OnePin PRI node using SEC registers
+//
+// Reads and writes the registers of a SEC node by number using
+// MD_OnePinReg. Every few seconds the LED flash time register is
+// changed, and all the registers are read back in one transaction.
+//
+// This sketch is for use with the MD_OnePin_Sec_Lib_Reg sketch
+//
+
+#include <MD_OnePin.h>
+#include <MD_OnePinReg.h>
+
+const uint8_t COMMS_PIN = 8;
+
+// SEC registers
+enum { REG_TIME, REG_MODE, REG_COUNT, REG_SIZE };
+
+MD_OnePin OP(COMMS_PIN);
+MD_OnePinReg REG(OP);
+
+void setup(void)
+{
+  Serial.begin(57600);
+  OP.begin();
+  if (!REG.writeReg(REG_MODE, 1))      // flashing
+    Serial.print(F("\nSEC not present"));
+}
+
+void loop(void)
+{
+  static uint8_t timeFlash = 10;    // 10ms units
+  MD_OnePin::packet_t reg[REG_SIZE];
+
+  if (!REG.writeReg(REG_TIME, timeFlash))
+    Serial.print(F("\nWRITE fail"));
+  timeFlash = (timeFlash >= 100) ? 10 : timeFlash + 10;
+
+  delay(3000);
+
+  if (!REG.readRegs(REG_TIME, REG_SIZE, reg))
+    Serial.print(F("\nREAD fail"));
+  else
+  {
+    Serial.print(F("\nTime "));
+    Serial.print(reg[REG_TIME]);
+    Serial.print(F(" Mode "));
+    Serial.print(reg[REG_MODE]);
+    Serial.print(F(" Count "));
+    Serial.print(reg[REG_COUNT]);
+  }
+}
@@ -9,8 +9,12 @@
 // count.
 //
 // The MD_OnePin_Test_Pri sketch can be used to write and read this SEC node.
+//
+// On ATmega processors the signals are timed using the free running Timer1
+// (see MD_OnePin_SecTimer.h), otherwise micros() is used.
 // 
 #include <MD_OnePin_Protocol.h>
+#include <MD_OnePin_SecTimer.h>
 
 // The comms pin needs to be an external interrupt pin.
 // See https://www.arduino.cc/reference/en/language/functions/external-interrupts/attachinterrupt/
@@ -52,12 +56,12 @@ const uint8_t LATCH_PIN = 2;
 // The falling edge is the start of a signal and the time
 // to the rising edge identifies the type of signal.
 volatile bool processSignal = false;       // flag for main program to process packet
-volatile uint32_t timeSignalDuration = 0;  // duration of the signal
+volatile opsTick_t timeSignalDuration = 0; // duration of the signal in timer ticks
 
 void pinISR(void)
 {
   static uint8_t ISRstate = 0;
-  static uint32_t timeStart;    // signal start time in micros()
+  static opsTick_t timeStart;   // signal start time in timer ticks
 
   if (!processSignal)
   {
@@ -70,7 +74,7 @@ void pinISR(void)
       if (digitalRead(OP_PIN) == LOW)
       {
         ISRstate = 1;
-        timeStart = micros();
+        timeStart = OPS_TIMER_NOW();
       }
       break;
 
@@ -78,7 +82,7 @@ void pinISR(void)
       // Timing the duration of the LOW dignal detected earlier.
       // The ISR is triggered when the signal changes to HIGH, so  
       // we time how long it took from IDLE to now.
-      timeSignalDuration = micros() - timeStart;
+      timeSignalDuration = (opsTick_t)(OPS_TIMER_NOW() - timeStart);
       ISRstate = 0;
       processSignal = true;   // tell main loop to process
       DBG_TOGGLE(LATCH_PIN);
@@ -95,6 +99,7 @@ void setup(void)
   SET_OUTPUT(LATCH_PIN);
 #endif
 
+  OPS_TIMER_BEGIN();
   SET_INPUT(OP_PIN);
   attachInterrupt(digitalPinToInterrupt(OP_PIN), pinISR, CHANGE);
 }
@@ -119,28 +124,32 @@ void loop(void)
   if (processSignal)
   {
     // Process the signal based on start duration
-    if (timeSignalDuration <= OPT_WR1_DETECT)      // less than the Write1 signal threshold
+    if (timeSignalDuration <= OPS_US_TO_TICKS(OPT_WR1_DETECT))      // less than the Write1 signal threshold
     {
-      rcvData |= (1 << bit);
+      rcvData |= ((opPriPacket_t)1 << bit);
       bit++;
       DBG_TOGGLE(LATCH_PIN);
       allRcv = (bit == BPP_PRI);
     }
-    else if (timeSignalDuration <= OPT_WR0_DETECT) // less than the Write0 signal threshold
+    else if (timeSignalDuration <= OPS_US_TO_TICKS(OPT_WR0_DETECT)) // less than the Write0 signal threshold
     {
       bit++;
       DBG_TOGGLE(LATCH_PIN);
       allRcv = (bit == BPP_PRI);
     }
-    else if (timeSignalDuration <= OPT_RD_DETECT)  // less than the Read request signal threshold
+    else if (timeSignalDuration <= OPS_US_TO_TICKS(OPT_RD_DETECT))  // less than the Read request signal threshold
     {
-      if (bit == 0) sndData = flashCount;         // we are just starting a new run, get latest data
       SET_OUTPUT(OP_PIN);
-      digitalWrite(OP_PIN, sndData & (1 << bit) ? HIGH : LOW);
+      digitalWrite(OP_PIN, sndData & ((mySecPacket_t)1 << bit) ? HIGH : LOW);
       delayMicroseconds(OPT_RD0_SIGNAL);
       SET_INPUT(OP_PIN);
       DBG_TOGGLE(LATCH_PIN);
       bit++;
+      if (bit == MY_BPP_SEC)                      // packet sent, next read starts a new one
+      {
+        bit = 0;
+        sndData = flashCount;                     // latch the next packet now, not in its first Read slot
+      }
     }
     else                              // the only thing left is a Reset signal
     {
@@ -150,11 +159,16 @@ void loop(void)
       SET_INPUT(OP_PIN);              // with PULLUP sets this high
       DBG_TOGGLE(LATCH_PIN);
       rcvData = bit = 0;
+      sndData = flashCount;           // latest data for the first packet read
     }
 
-    // if we have received/sent a whole packet, deal with the data
+    // if we have received a whole packet, deal with the data and reset 
+    // accumulation for the next packet in case PRI is streaming data
     if (allRcv)
+    {
       timeLedFlash = rcvData;
+      rcvData = bit = 0;
+    }
 
     processSignal = false;     // reset the flag to stop blocking IS
   }
@@ -0,0 +1,60 @@
+// MD_OnePin example SEC node
+// 
+// An example sketch using the packaged SEC implementation (MD_OnePin_Sec.h).
+// All the link signaling is done in the library pin ISR, so the loop() 
+// only deals with the application data.
+//
+// The application flashes a LED at a rate determined by an internal variable.
+// Data writes from the PRI will set a new rate in milliseconds for the flash 
+// rate. Data Reads from the PRI will cause the SEC to send the current flash 
+// count.
+//
+// If PRI uses attention mode the SEC can ask PRI to read the new flash 
+// count each time it changes instead of PRI polling it.
+//
+// The MD_OnePin_Test_Pri sketch can be used to write and read this SEC node.
+// 
+#include <MD_OnePin_Sec.h>
+
+// The comms pin needs to be an external interrupt pin.
+// See https://www.arduino.cc/reference/en/language/functions/external-interrupts/attachinterrupt/
+// for valid pins for different architectures.
+const uint8_t OP_PIN = 2;
+
+// Set true if PRI is in attention mode (MD_OnePin::setAttentionMode()).
+const bool ASK_ATTENTION = false;
+
+// LED management parameters
+const uint8_t LED_PIN = 4;
+uint32_t timeLedFlash = 1000;   // LED flash time
+uint32_t timeLedStart = 0;      // LED base time for period
+opSecPacket_t flashCount = 0;   // LED flash count
+bool attnPending = false;       // attention signal still to be sent
+
+void setup(void)
+{
+  pinMode(LED_PIN, OUTPUT);
+  opsBegin(OP_PIN);
+  opsSetReply(flashCount);
+}
+
+void loop(void)
+{
+  // new flash rate from PRI
+  while (opsAvailable())
+    timeLedFlash = opsRead();
+
+  // flash the LED
+  if (millis() - timeLedStart >= timeLedFlash)
+  {
+    digitalWrite(LED_PIN, digitalRead(LED_PIN) == LOW ? HIGH : LOW);
+    timeLedStart = millis();
+    flashCount++;
+    opsSetReply(flashCount);
+    attnPending = ASK_ATTENTION;
+  }
+
+  // tell PRI there is a new count, trying again later if the link is busy
+  if (attnPending && opsAttention())
+    attnPending = false;
+}
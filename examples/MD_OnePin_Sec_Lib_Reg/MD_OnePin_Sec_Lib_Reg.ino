@@ -0,0 +1,86 @@
+// MD_OnePin example SEC node with registers
+//
+// An example sketch using the packaged SEC implementation (MD_OnePin_Sec.h)
+// with a register table. PRI reads and writes the registers by number
+// using MD_OnePinReg, and the library ISR does all the register access,
+// so the loop() only deals with the application.
+//
+// The application flashes a LED. The registers are
+// 0 - flash time in 10ms units (read/write)
+// 1 - mode, 0 = off, 1 = flashing, 2 = on (read/write)
+// 2 - flash count (read only)
+// Registers are read as SEC packets, so with the default 8 bit SEC packet
+// the flash count wraps at 256.
+//
+// The MD_OnePin_Reg_Pri sketch can be used to read and write this SEC node.
+//
+#include <MD_OnePin_Sec.h>
+
+// The comms pin needs to be an external interrupt pin.
+// See https://www.arduino.cc/reference/en/language/functions/external-interrupts/attachinterrupt/
+// for valid pins for different architectures.
+const uint8_t OP_PIN = 2;
+
+// LED management parameters
+const uint8_t LED_PIN = 4;
+uint32_t timeLedStart = 0;      // LED base time for period
+
+// Register data
+enum { REG_TIME, REG_MODE, REG_COUNT };
+volatile opPriPacket_t regData[] = { 100, 1, 0 };
+volatile bool modeChanged = false;
+
+void onMode(uint8_t reg, opPriPacket_t value)
+// called in the ISR, so just flag the change for loop()
+{
+  (void)reg;
+  (void)value;
+  modeChanged = true;
+}
+
+const opsRegister_t regTable[] =
+{
+  { &regData[REG_TIME],  true,  nullptr },
+  { &regData[REG_MODE],  true,  onMode },
+  { &regData[REG_COUNT], false, nullptr },
+};
+
+opPriPacket_t getReg(uint8_t reg)
+// multi byte register data is also used by the ISR
+{
+  opPriPacket_t v;
+
+  noInterrupts();
+  v = regData[reg];
+  interrupts();
+
+  return(v);
+}
+
+void setup(void)
+{
+  pinMode(LED_PIN, OUTPUT);
+  opsBegin(OP_PIN);
+  opsSetRegisters(regTable, sizeof(regTable) / sizeof(regTable[0]));
+}
+
+void loop(void)
+{
+  // steady LED modes
+  if (modeChanged)
+  {
+    modeChanged = false;
+    if (getReg(REG_MODE) == 0) digitalWrite(LED_PIN, LOW);
+    if (getReg(REG_MODE) == 2) digitalWrite(LED_PIN, HIGH);
+  }
+
+  // flash the LED
+  if (getReg(REG_MODE) == 1 && millis() - timeLedStart >= getReg(REG_TIME) * 10)
+  {
+    digitalWrite(LED_PIN, digitalRead(LED_PIN) == LOW ? HIGH : LOW);
+    timeLedStart = millis();
+    noInterrupts();
+    regData[REG_COUNT]++;
+    interrupts();
+  }
+}
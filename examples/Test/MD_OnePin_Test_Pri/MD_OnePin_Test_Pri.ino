@@ -11,6 +11,7 @@
 //
 
 #include <MD_OnePin.h>
+#include <MD_OnePinBench.h>
 #include <MD_cmdProcessor.h>
 
 const uint8_t COMMS_PIN = 8;  // pin used for communications
@@ -25,6 +26,7 @@ uint16_t timeDelay = 1000;    // delay time when iterating
 enum { S_IDLE, S_READ, S_WRITE, S_RW } loopState = S_IDLE;  // main loop execution state
 MD_OnePin::packet_t writeData = 0;      // write data register
 MD_OnePin OP(COMMS_PIN);
+MD_OnePinBench BM(OP);
 
 #ifndef ARRAY_SIZE
 #define ARRAY_SIZE(a) (sizeof(a)/sizeof((a)[0]))
@@ -48,6 +50,7 @@ void handlerR1(char * param)
   data = OP.read();
   Serial.print(data, HEX);
   if (!OP.isPresent()) Serial.print(F(" failed"));
+  else if (!OP.isCrcOk()) Serial.print(F(" CRC error"));
 }
 
 void handlerW(char* param) 
@@ -70,6 +73,257 @@ void handlerW(char* param)
   }
 }
 
+void handlerTR(char* param)
+{
+  MD_OnePin::packet_t reply;
+  MD_OnePin::packet_t cmd = strtoul(param, nullptr, 0);
+
+  Serial.print(F("\nTransact 0x"));
+  Serial.print(cmd, HEX);
+  if (!OP.transact(cmd, reply)) Serial.print(F(" failed"));
+  Serial.print(F(" reply 0x"));
+  Serial.print(reply, HEX);
+}
+
+const uint8_t BUF_SIZE = 64;   // maximum burst transfer size
+
+void handlerRB(char* param)
+{
+  uint8_t buf[BUF_SIZE];
+  size_t len = strtoul(param, nullptr, 0);
+
+  if (len > BUF_SIZE) len = BUF_SIZE;
+  Serial.print(F("\nRead buffer"));
+  if (!OP.readBuffer(buf, len)) Serial.print(F(" failed"));
+  for (size_t i = 0; i < len; i++)
+  {
+    Serial.print(F(" 0x"));
+    Serial.print(buf[i], HEX);
+  }
+}
+
+void handlerRS(char* param)
+{
+  MD_OnePin::packet_t buf[BUF_SIZE / 4];
+  uint16_t count = strtoul(param, nullptr, 0);
+
+  if (count > ARRAY_SIZE(buf)) count = ARRAY_SIZE(buf);
+  Serial.print(F("\nRead stream"));
+  if (!OP.readStream(buf, count)) Serial.print(F(" failed"));
+  for (uint16_t i = 0; i < count; i++)
+  {
+    Serial.print(F(" 0x"));
+    Serial.print(buf[i], HEX);
+  }
+}
+
+void handlerWB(char* param)
+{
+  uint8_t buf[BUF_SIZE];
+  size_t len = strtoul(param, nullptr, 0);
+
+  if (len > BUF_SIZE) len = BUF_SIZE;
+  for (size_t i = 0; i < len; i++)
+    buf[i] = i;
+  Serial.print(F("\nWrite buffer "));
+  Serial.print(len);
+  Serial.print(F(" bytes "));
+  if (!OP.writeBuffer(buf, len)) Serial.print(F("failed"));
+}
+
+void handlerRF(char* param)
+{
+  uint8_t buf[BUF_SIZE];
+  uint8_t len;
+  bool ok = OP.readFrame(buf, BUF_SIZE, len);
+
+  Serial.print(F("\nRead frame "));
+  Serial.print(len);
+  Serial.print(F(" bytes"));
+  if (!ok) Serial.print(F(" failed"));
+  for (uint8_t i = 0; i < len && i < BUF_SIZE; i++)
+  {
+    Serial.print(F(" 0x"));
+    Serial.print(buf[i], HEX);
+  }
+}
+
+void handlerWF(char* param)
+{
+  uint8_t buf[BUF_SIZE];
+  size_t len = strtoul(param, nullptr, 0);
+
+  if (len > BUF_SIZE) len = BUF_SIZE;
+  for (size_t i = 0; i < len; i++)
+    buf[i] = i;
+  Serial.print(F("\nWrite frame "));
+  Serial.print(len);
+  Serial.print(F(" bytes "));
+  if (!OP.writeFrame(buf, len)) Serial.print(F("failed"));
+}
+
+void handlerN(char* param)
+{
+  Serial.print(F("\nNegotiated T (us): "));
+  Serial.print(OP.negotiate());
+}
+
+void handlerT(char* param)
+{
+  if (strlen(param) != 0)
+  {
+    if (!OP.setTimeslot(strtoul(param, nullptr, 0)))
+      Serial.print(F("\nSEC not present"));
+  }
+  Serial.print(F("\nT (us): "));
+  Serial.print(OP.getTimeslot());
+}
+
+void printBench(const char* op, MD_OnePinBench::result_t &r)
+{
+  Serial.print(F("\n"));
+  Serial.print(op);
+  Serial.print(F(" T="));
+  Serial.print(r.t);
+  if (r.count == 0)
+  {
+    Serial.print(F(" not accepted"));
+    return;
+  }
+  Serial.print(F(" ops="));
+  Serial.print(r.count);
+  Serial.print(F(" fail="));
+  Serial.print(r.fail);
+  Serial.print(F(" bps="));
+  Serial.print(r.bitsPerSec);
+  Serial.print(F(" us min/avg/max/p99="));
+  Serial.print(r.latMin);
+  Serial.write('/');
+  Serial.print(r.latAvg);
+  Serial.write('/');
+  Serial.print(r.latMax);
+  Serial.write('/');
+  Serial.print(r.latP99);
+}
+
+void handlerBM(char* param)
+{
+  const uint16_t t[] = { OPT, (3 * OPT) / 4, OPT / 2, (3 * OPT) / 8, OPT / 4 };
+  MD_OnePinBench::result_t res[ARRAY_SIZE(t)];
+  uint16_t count = strtoul(param, nullptr, 0);
+
+  if (count == 0) count = 100;
+  Serial.print(F("\nCalibration (us) switch="));
+  Serial.print(BM.getSwitchTime());
+  Serial.print(F(" write="));
+  Serial.print(BM.getWriteTime());
+  Serial.print(F(" bpp PRI/SEC="));
+  Serial.print(BPP_PRI);
+  Serial.write('/');
+  Serial.print(BPP_SEC);
+
+  BM.sweep(MD_OnePinBench::BENCH_WRITE, count, t, ARRAY_SIZE(t), res);
+  for (uint8_t i = 0; i < ARRAY_SIZE(t); i++)
+    printBench("W", res[i]);
+  BM.sweep(MD_OnePinBench::BENCH_READ, count, t, ARRAY_SIZE(t), res);
+  for (uint8_t i = 0; i < ARRAY_SIZE(t); i++)
+    printBench("R", res[i]);
+}
+
+#if OP_STATS
+void handlerS(char* param)
+{
+  const opStats_t &s = OP.getStats();
+
+  Serial.print(F("\nTransactions: "));
+  Serial.print(s.transactions);
+  Serial.print(F("\nBits sent/received: "));
+  Serial.print(s.bitsSent);
+  Serial.write('/');
+  Serial.print(s.bitsRecv);
+  Serial.print(F("\nPresence fail: "));
+  Serial.print(s.presenceFail);
+  Serial.print(F("\nCRC errors: "));
+  Serial.print(s.crcErrors);
+  Serial.print(F("\nBlocked (us): "));
+  Serial.print(s.usBlocked);
+  Serial.print(F("\nMax overrun (us): "));
+  Serial.print(s.maxOverrun);
+  OP.clearStats();
+}
+#endif
+
+#if OP_TRACE
+void handlerTD(char* param)
+{
+  static const char *name[] = { "RST", "SYN", "FRM", "WR0", "WR1", "RD ", "S0 ", "S1 ", "S2 ", "S3 " };
+  opTrace_t r;
+
+  Serial.print(F("\nSignal  LOW  HIGH Smp"));
+  while (OP.readTrace(r))
+  {
+    uint8_t type = r.type & OPTR_SIGNAL_MASK;
+
+    Serial.print(F("\n"));
+    Serial.print(type < ARRAY_SIZE(name) ? name[type] : "?  ");
+    Serial.print(F("  "));
+    Serial.print(r.low);
+    Serial.print(F("  "));
+    Serial.print(r.high);
+    Serial.print(F("  "));
+    Serial.print((r.type & OPTR_SAMPLE_HIGH) ? '1' : '0');
+  }
+}
+#endif
+
+void handlerOD(char* param)
+{
+  bool on = !OP.isOverdrive();
+
+  if (!OP.setOverdrive(on))
+    Serial.print(F("\nOverdrive not supported by SEC"));
+  Serial.print(F("\nOverdrive: "));
+  Serial.print(OP.isOverdrive() ? "On" : "Off");
+  Serial.print(F(" T (us): "));
+  Serial.print(OP.getTimeslot());
+}
+
+void attnISR(void) { OP.attentionISR(); }
+
+void handlerAT(char* param)
+{
+  bool on = !OP.isAttentionMode();
+
+  // Without an interrupt on the comms pin hasAttention() polls the link
+  if (digitalPinToInterrupt(COMMS_PIN) != NOT_AN_INTERRUPT)
+  {
+    if (on) attachInterrupt(digitalPinToInterrupt(COMMS_PIN), attnISR, FALLING);
+    else    detachInterrupt(digitalPinToInterrupt(COMMS_PIN));
+  }
+  OP.setAttentionMode(on);
+  Serial.print(F("\nAttention mode: "));
+  Serial.print(on ? "On" : "Off");
+}
+
+void handlerC(char* param)
+{
+  static bool crc = false;
+
+  crc = !crc;
+  OP.setCrc(crc);
+  Serial.print(F("\nCRC: "));
+  Serial.print(crc ? "On" : "Off");
+}
+
+void handlerE(char* param)
+{
+  bool twoBit = (OP.getEncoding() == MD_OnePin::ENC_1BIT);
+
+  OP.setEncoding(twoBit ? MD_OnePin::ENC_2BIT : MD_OnePin::ENC_1BIT);
+  Serial.print(F("\nWrite encoding: "));
+  Serial.print(twoBit ? "2 bit" : "1 bit");
+}
+
 void handlerO(char* param) 
 { 
   enableOutput = !enableOutput; 
@@ -106,9 +360,28 @@ const MD_cmdProcessor::cmdItem_t PROGMEM cmdTable[] =
   { "r1", handlerR1, "",   "Iterate Read from SEC", 1 },
   { "w",  handlerW,  "[n]","Iterate Write [or simple Write n] to SEC", 1 },
   { "rw", handlerRW, "",   "Alternate Reads and Writes", 1 },
-
+  { "tr", handlerTR, "n",  "Write n and read the reply in one transaction", 1 },
+  { "rb", handlerRB, "n",  "Read n bytes from SEC in one transaction", 1 },
+  { "rs", handlerRS, "n",  "Read n packets from SEC as one stream", 1 },
+  { "wb", handlerWB, "n",  "Write n bytes (0..n-1) to SEC in one transaction", 1 },
+  { "rf", handlerRF, "",   "Read a length-prefixed frame from SEC", 1 },
+  { "wf", handlerWF, "n",  "Write an n byte (0..n-1) length-prefixed frame to SEC", 1 },
+
+  { "at", handlerAT, "",  "Toggle SEC Attention mode", 2 },
   { "b",  handlerB,  "",  "Toggle Benchmarking output", 2 },
+  { "bm", handlerBM, "[n]", "Benchmark [n] transactions over a range of T", 2 },
+  { "c",  handlerC,  "",  "Toggle packet CRC (SEC must match)", 2 },
   { "d",  handlerD,  "n", "Set write Data register value (uint32_t)", 2 },
+  { "e",  handlerE,  "",  "Toggle 1/2 bit write Encoding (SEC must match)", 2 },
+  { "n",  handlerN,  "",  "Negotiate the smallest reliable timeslot T", 2 },
+  { "t",  handlerT,  "[n]", "Show [or set] the timeslot T (us)", 2 },
+#if OP_STATS
+  { "s",  handlerS,  "",  "Show and clear link Statistics", 2 },
+#endif
+#if OP_TRACE
+  { "td", handlerTD, "",  "Dump the link signal Trace", 2 },
+#endif
+  { "od", handlerOD, "",  "Toggle Overdrive mode", 2 },
   { "o",  handlerO,  "",  "Toggle RW Output to serial monitor", 2},
   { "p",  handlerP,  "n", "Set main loop execution Period (ms)", 2 },
   { "x",  handlerX,  "",  "Stop main loop eXecution", 2 },
@@ -146,6 +419,9 @@ void loop(void)
 
   CP.run();
 
+  if (OP.isAttentionMode() && OP.hasAttention())
+    Serial.print(F("\nSEC Attention"));
+
   if (millis() - timeStart >= timeDelay)
   {
     if (RWalternate) loopState = (loopState == S_READ ? S_WRITE : S_READ);
@@ -6,6 +6,10 @@
 // This application can serve as the start of a SEC application 
 // that does something useful with the data exchanges.
 //
+// This SEC supports run time timeslot changes, test frames and 
+// write-read transactions, so it can be used to negotiate the link 
+// timeslot from PRI.
+//
 #include <MD_OnePin_Protocol.h>
 
 #ifndef OP_DEBUG_DIGITAL
@@ -14,7 +18,7 @@
 
 #if OP_DEBUG_DIGITAL
 #define DBG_PIN 7
-#define DBG_FLIP digitalWrite(DBG_PIN, digitalRead(DBG_PIN) ? LOP : HIGH)
+#define DBG_FLIP digitalWrite(DBG_PIN, digitalRead(DBG_PIN) ? LOW : HIGH)
 #else
 #define DBG_FLIP
 #endif
@@ -22,6 +26,10 @@
 // A SEC may be read-only, in which case it will not respond to write messages.
 #define SEC_IS_READ_ONLY  0   // set to 1 for READ_ONLY functionality
 
+// PRI may write using 2 bit symbols (MD_OnePin::ENC_2BIT) instead of
+// Write 0/1 signals. Set this to match the setting in PRI.
+#define SEC_WRITE_2BIT  0     // set to 1 for 2 bit write symbols
+
 // The comms pin needs to be an external interrupt pin.
 // See https://www.arduino.cc/reference/en/language/functions/external-interrupts/attachinterrupt/
 // for valid pins for different architectures.
@@ -30,7 +38,26 @@ const uint8_t OP_PIN = 2;
 // SEC packet size and typedef.
 // Override the default values for this SEC by chaning here
 const uint8_t MY_BPP_SEC = BPP_SEC;
-typedef opSeciPacket_t mySecPacket_t;
+typedef opSecPacket_t mySecPacket_t;
+
+// Link timeslot management.
+// The SEC timing follows the timeslot T set by PRI using a Sync signal.
+const uint16_t MY_OPT_MIN = OPT / 4;  // smallest timeslot this SEC accepts
+uint16_t timeSlot = OPT;              // current timeslot T
+uint16_t timeWr1Detect = OPT_WR1_DETECT;
+uint16_t timeWr0Detect = OPT_WR0_DETECT;
+uint16_t timeRdDetect = OPT_RD_DETECT;
+uint16_t timeSymDetect[4] = { OPT_SYM0_DETECT, OPT_SYM1_DETECT, OPT_SYM2_DETECT, OPT_SYM3_DETECT };
+
+void setTimeslot(uint16_t t)
+{
+  timeSlot = t;
+  timeWr1Detect = OPT_WR1_DETECT_T(t);
+  timeWr0Detect = OPT_WR0_DETECT_T(t);
+  timeRdDetect = OPT_RD_DETECT_T(t);
+  for (uint8_t i = 0; i < 4; i++)
+    timeSymDetect[i] = OPT_SYM_DETECT_T(t, i);
+}
 
 // ---- Macros for local inline code (time critical sections)
 #define SET_TO_INPUT  pinMode(OP_PIN, INPUT_PULLUP)
@@ -77,7 +104,7 @@ void setup(void)
   Serial.begin(57600);
 #if OP_DEBUG_DIGITAL
   pinMode(DBG_PIN, OUTPUT);
-  digitalWrite(DBG_PIN, LOP);
+  digitalWrite(DBG_PIN, LOW);
 #endif
 
   SET_TO_INPUT;
@@ -87,9 +114,14 @@ void setup(void)
 void loop(void)
 {
   // ---- Comms data coordination
-  static mySecPacket_t sndData = 0;
+  static mySecPacket_t sndData = 0;   // packet being sent
+  static mySecPacket_t sndCount = 0;  // data for the next packet sent
   static opPriPacket_t rcvData = 0;
+  static opPriPacket_t rcvLast = 0;   // last complete packet received
   static uint8_t bit = 0;
+  static bool syncRcv = false;        // Sync received, next signal is the Reset at the new T
+  static bool testFrame = false;      // in a test frame, reads return the last packet received
+  static bool turnaround = false;     // a Read now is a write-read turnaround slot
   bool allRcv = false;    // all bits received from PRI
   bool allSnd = false;    // all bits sent from PRI
 
@@ -101,53 +133,110 @@ void loop(void)
     // the interrupt during while processing.
     detachInterrupt(digitalPinToInterrupt(OP_PIN));
 
-    // Process the signal based on start duration (in increasing order)
-#if !SEC_IS_READ_ONLY
-    if (timeSignalDuration <= OPT_WR1_DETECT)      // less than the Write1 signal threshold
+    // A Read straight after a whole packet is received is the turnaround
+    // slot for a write-read transaction. Any other signal ends it.
+    bool inTurnaround = turnaround;
+    turnaround = false;
+
+    // Process the signal based on start duration (in increasing order).
+    // Sync is checked first as it is always at the default timeslot and 
+    // the signal after a Sync is always the Reset at the new timeslot.
+    if (timeSignalDuration > OPT_SYNC_DETECT)     // Sync signal
+    {
+      SET_TO_OUTPUT;
+      digitalWrite(OP_PIN, LOW);
+      delayMicroseconds(OPT_RST_PRESENCE);
+      SET_TO_INPUT;
+      rcvData = bit = 0;
+      syncRcv = true;
+      testFrame = false;
+    }
+    else if (syncRcv)                             // Reset at the new timeslot
+    {
+      uint16_t t = timeSignalDuration / OPT_RST_SIGNAL_T(1);
+
+      syncRcv = false;
+      if (t >= MY_OPT_MIN)    // otherwise no presence and keep the current T
+      {
+        setTimeslot(t);
+        SET_TO_OUTPUT;
+        digitalWrite(OP_PIN, LOW);
+        delayMicroseconds(OPT_RST_PRESENCE_T(timeSlot));
+        SET_TO_INPUT;
+        testFrame = true;
+      }
+    }
+#if !SEC_IS_READ_ONLY && SEC_WRITE_2BIT
+    else if (timeSignalDuration <= timeSymDetect[3])    // less than the symbol 3 signal threshold
+    {
+      uint8_t sym = 3;
+
+      for (uint8_t i = 0; i < 3; i++)
+        if (timeSignalDuration <= timeSymDetect[i]) { sym = i; break; }
+      rcvData |= ((opPriPacket_t)sym << bit);
+      bit += 2;
+      allRcv = (bit >= BPP_PRI);    // last symbol of an odd size packet carries 1 bit
+    }
+    else if (timeSignalDuration <= timeRdDetect)        // less than the Read request signal threshold
+#elif !SEC_IS_READ_ONLY
+    else if (timeSignalDuration <= timeWr1Detect)       // less than the Write1 signal threshold
     {
-      rcvData |= (1 << bit);
+      rcvData |= ((opPriPacket_t)1 << bit);
       bit++;
       allRcv = (bit == BPP_PRI);
     }
-    else if (timeSignalDuration <= OPT_WR0_DETECT) // less than the Write0 signal threshold
+    else if (timeSignalDuration <= timeWr0Detect)       // less than the Write0 signal threshold
     {
       bit++;
       allRcv = (bit == BPP_PRI);
     }
-    else if (timeSignalDuration <= OPT_RD_DETECT)  // less than the Read request signal threshold
+    else if (timeSignalDuration <= timeRdDetect)        // less than the Read request signal threshold
 #else  // READ_ONLY
-    if ((timeSignalDuration > OPT_WR0_DETECT) && (timeSignalDuration <= OPT_RD_DETECT))
+    else if ((timeSignalDuration > timeWr0Detect) && (timeSignalDuration <= timeRdDetect))
 #endif
     {
-      SET_TO_OUTPUT;
-      digitalWrite(OP_PIN, sndData & (1 << bit) ? HIGH : LOW);
-      delayMicroseconds(OPT_RD0_SIGNAL);
-      SET_TO_INPUT;
-      DBG_FLIP;
-      bit++;
-      allSnd = (bit == MY_BPP_SEC);
+      if (inTurnaround)
+      {
+        // the reply is always ready, so leave the link HIGH
+      }
+      else
+      {
+        if (bit == 0) sndData = testFrame ? (mySecPacket_t)rcvLast : sndCount;  // starting a new packet
+        SET_TO_OUTPUT;
+        digitalWrite(OP_PIN, sndData & ((mySecPacket_t)1 << bit) ? HIGH : LOW);
+        delayMicroseconds(OPT_RD0_SIGNAL_T(timeSlot));
+        SET_TO_INPUT;
+        DBG_FLIP;
+        bit++;
+        allSnd = (bit == MY_BPP_SEC);
+      }
     }
     else                              // the only thing left is a Reset signal
     {
       SET_TO_OUTPUT;
       digitalWrite(OP_PIN, LOW);
-      delayMicroseconds(OPT_RST_PRESENCE);
+      delayMicroseconds(OPT_RST_PRESENCE_T(timeSlot));
       SET_TO_INPUT;    // with PULLUP sets this high
       rcvData = bit = 0;
+      testFrame = false;
     }
 
-    // if we have received or sent a whole packet,
-    // deal with the data and reset accumulation counters.
+    // if we have received or sent a whole packet, deal with the data 
+    // and reset accumulation counters in case PRI is streaming packets.
     if (allRcv)
     {
       opPriPacket_t dataNew = rcvData;  // copy data in case ISR gets called
 
+      rcvLast = dataNew;
+      rcvData = bit = 0;
+      turnaround = true;
       Serial.write('\n');
       Serial.print(dataNew, HEX);
     }
     if (allSnd)
     {
-      sndData++;
+      bit = 0;
+      if (!testFrame) sndCount++;
     }
 
     // start processing interrupts again
@@ -0,0 +1,56 @@
+#pragma once
+/**
+ * \file
+ * \brief Host replacement for the Arduino core used by the OnePin link simulator.
+ *
+ * Only the parts of the Arduino API used by the MD_OnePin PRI and the
+ * packaged SEC code are provided. The pin and timing functions are
+ * implemented by the simulated wire in MD_OnePin_SimWire.cpp, which runs
+ * in virtual time, so delayMicroseconds() and micros() do not depend on
+ * the speed of the host.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define HIGH  1
+#define LOW   0
+
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define HEX 16
+#define BIN 2
+
+#define F(s)  s
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+
+#define digitalPinToInterrupt(p)  (p)
+
+typedef uint8_t byte;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+void delayMicroseconds(unsigned int us);
+void delay(unsigned long ms);
+unsigned long micros(void);
+unsigned long millis(void);
+
+// PRI and SEC are separate processors, so the PRI interrupt masking does
+// not hold off the SEC ISR. The SEC API calls all run between simulated
+// PRI waits, so they are atomic without masking.
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+void attachInterrupt(uint8_t irq, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t irq);
@@ -0,0 +1,214 @@
+// Host simulation of a MD_OnePin link
+//
+// Runs the MD_OnePin PRI code and the packaged SEC code (MD_OnePin_Sec)
+// against each other over a simulated wire in virtual time. Random
+// packets are written to and read from SEC and checked, and the link
+// throughput is worked out from the virtual time taken.
+//
+// The wire and processor timing can be changed from the command line
+// to find the timing margins of the protocol, and a run over a range of
+// timeslots T shows where the link stops being reliable.
+//
+// See README.md in this folder for how to build and run the simulator.
+//
+
+#include <stdio.h>
+#include <MD_OnePin.h>
+#include <MD_OnePin_Sec.h>
+#include <MD_OnePin_SimWire.h>
+
+static const uint16_t T_STEP = 5;   // sweep timeslot step (us)
+
+typedef struct
+{
+  uint32_t count;       // packets each way at each T
+  uint16_t t;           // timeslot to test
+  bool sweep;           // test from OPT down to OPS_OPT_MIN
+  bool limits;          // check the T limits first
+  bool verbose;         // print each error
+} runConfig_t;
+
+typedef struct
+{
+  uint32_t wrErrors;    // packets written and not received correctly
+  uint32_t rdErrors;    // packets read incorrectly
+  uint32_t noPresence;  // transactions with no presence response
+  double wrKbps;        // write throughput
+  double rdKbps;        // read throughput
+} runResult_t;
+
+static MD_OnePin OP(SIM_PRI_PIN, OPS_BPP_PRI, OPS_BPP_SEC);
+
+static void usage(void)
+{
+  printf("\nUsage: MD_OnePin_Sim [options]");
+  printf("\n -n count  packets each way at each T (10000)");
+  printf("\n -t us     timeslot T (%u)", OPT);
+  printf("\n -s        sweep T from %u down to %u", OPT, OPS_OPT_MIN);
+  printf("\n -m        check the T limits (%u is accepted, %u and %u are not)", OPT_MAX, OPT_MAX + 1, OPS_OPT_MIN - 1);
+  printf("\n -i ns     PRI I/O time (500)");
+  printf("\n -p ns     PRI delay jitter (0)");
+  printf("\n -l ns     SEC ISR latency (3000)");
+  printf("\n -j ns     SEC ISR jitter (0)");
+  printf("\n -r ns     link rise time (500)");
+  printf("\n -x n      random seed (1)");
+  printf("\n -v        print each error");
+  printf("\n");
+}
+
+static uint32_t packetMask(uint8_t bpp)
+{
+  return(bpp >= 32 ? 0xffffffff : (((uint32_t)1 << bpp) - 1));
+}
+
+static double kbps(uint32_t bits, uint64_t ns)
+{
+  return(ns == 0 ? 0 : (bits * 1e6) / ns);
+}
+
+static void run(const runConfig_t &cfg, runResult_t &res)
+{
+  uint64_t start;
+
+  memset(&res, 0, sizeof(res));
+
+  // PRI writes
+  start = simNow();
+  for (uint32_t i = 0; i < cfg.count; i++)
+  {
+    MD_OnePin::packet_t data = simRandom() & packetMask(OPS_BPP_PRI);
+    bool ok = false;
+
+    if (!OP.write(data)) res.noPresence++;
+    while (opsAvailable())
+    {
+      opPriPacket_t rx = opsRead();
+
+      ok = (rx == data);
+      if (!ok && cfg.verbose)
+        printf("\nT%u write %lu: sent 0x%lx received 0x%lx", OP.getTimeslot(), (unsigned long)i, (unsigned long)data, (unsigned long)rx);
+    }
+    if (!ok) res.wrErrors++;
+  }
+  res.wrKbps = kbps(cfg.count * OPS_BPP_PRI, simNow() - start);
+
+  // PRI reads
+  start = simNow();
+  for (uint32_t i = 0; i < cfg.count; i++)
+  {
+    opSecPacket_t data = simRandom() & packetMask(OPS_BPP_SEC);
+    MD_OnePin::packet_t rx;
+
+    opsSetReply(data);
+    rx = OP.read();
+    if (!OP.isPresent()) res.noPresence++;
+    if (rx != data)
+    {
+      res.rdErrors++;
+      if (cfg.verbose)
+        printf("\nT%u read %lu: sent 0x%lx received 0x%lx", OP.getTimeslot(), (unsigned long)i, (unsigned long)data, (unsigned long)rx);
+    }
+  }
+  res.rdKbps = kbps(cfg.count * OPS_BPP_SEC, simNow() - start);
+}
+
+static uint32_t checkLimits(void)
+{
+  // A T that is refused leaves both ends at the previous T
+  static const struct { uint16_t t; bool ok; } test[] =
+  {
+    { OPT_MAX,          true },   // Reset just shorter than a Sync
+    { OPT_MAX + 1,      false },  // refused by PRI, Reset would be a Sync
+    { OPS_OPT_MIN - 1,  false },  // refused by SEC
+    { OPT_MIN - 1,      false },  // refused by PRI
+  };
+  uint32_t errors = 0;
+
+  for (uint8_t i = 0; i < sizeof(test) / sizeof(test[0]); i++)
+  {
+    uint16_t tPrev = OP.getTimeslot();
+    bool ok = OP.setTimeslot(test[i].t);
+    uint16_t tNow = OP.getTimeslot();
+    MD_OnePin::packet_t data = simRandom() & packetMask(OPS_BPP_PRI);
+    bool linkOk = OP.write(data) && opsAvailable() && opsRead() == data;
+    bool pass = (ok == test[i].ok) && (tNow == (ok ? test[i].t : tPrev)) && linkOk;
+
+    printf("\nLimit T=%u %s, T now %u, link %s: %s", test[i].t, ok ? "accepted" : "refused",
+      tNow, linkOk ? "ok" : "failed", pass ? "pass" : "FAIL");
+    if (!pass) errors++;
+    while (opsAvailable()) opsRead();
+  }
+
+  return(errors);
+}
+
+int main(int argc, char *argv[])
+{
+  runConfig_t cfg = { 10000, OPT, false, false, false };
+  simConfig_t sim = { 500, 0, 3000, 0, 500, 1 };
+  uint32_t errors = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *a = argv[i];
+    unsigned long v = (i + 1 < argc) ? strtoul(argv[i + 1], nullptr, 0) : 0;
+
+    if (a[0] != '-' || a[1] == '\0' || a[2] != '\0') { usage(); return(2); }
+    switch (a[1])
+    {
+    case 's': cfg.sweep = true; continue;
+    case 'm': cfg.limits = true; continue;
+    case 'v': cfg.verbose = true; continue;
+    case 'n': cfg.count = v; break;
+    case 't': cfg.t = v; break;
+    case 'i': sim.priIo = v; break;
+    case 'p': sim.priJitter = v; break;
+    case 'l': sim.secLatency = v; break;
+    case 'j': sim.secJitter = v; break;
+    case 'r': sim.riseTime = v; break;
+    case 'x': sim.seed = v; break;
+    default: usage(); return(2);
+    }
+    if (++i >= argc) { usage(); return(2); }
+  }
+
+  simBegin(sim);
+  opsBegin(SIM_SEC_PIN);
+  OP.begin();
+  OP.setEncoding(OPS_WRITE_2BIT ? MD_OnePin::ENC_2BIT : MD_OnePin::ENC_1BIT);
+  OP.setCrc(OPS_CRC);
+
+  printf("BPP PRI/SEC=%u/%u, %s bit writes, PRI io=%luns jitter=%luns, SEC latency=%luns jitter=%luns, rise=%luns",
+    OPS_BPP_PRI, OPS_BPP_SEC, OPS_WRITE_2BIT ? "2" : "1",
+    (unsigned long)sim.priIo, (unsigned long)sim.priJitter,
+    (unsigned long)sim.secLatency, (unsigned long)sim.secJitter, (unsigned long)sim.riseTime);
+  if (cfg.limits) errors += checkLimits();
+  printf("\n  T  WrErr  RdErr  NoPrs  Wr kbit/s  Rd kbit/s");
+
+  for (int t = (cfg.sweep ? OPT : cfg.t); t > 0 && t >= (cfg.sweep ? OPS_OPT_MIN : cfg.t); t -= T_STEP)
+  {
+    runResult_t res;
+
+    if (t != OP.getTimeslot() && !OP.setTimeslot(t))
+    {
+      printf("\n%3d  T not accepted", t);
+      errors++;
+      if (!cfg.sweep) break;
+      continue;
+    }
+
+    run(cfg, res);
+    errors += res.wrErrors + res.rdErrors + res.noPresence;
+    printf("\n%3d %6lu %6lu %6lu %10.1f %10.1f", t,
+      (unsigned long)res.wrErrors, (unsigned long)res.rdErrors, (unsigned long)res.noPresence,
+      res.wrKbps, res.rdKbps);
+
+    if (!cfg.sweep) break;
+  }
+
+  printf("\nEdges=%lu ISR=%lu contention=%lu\n",
+    (unsigned long)simGetStats().edges, (unsigned long)simGetStats().isrRuns,
+    (unsigned long)simGetStats().contention);
+
+  return(errors == 0 ? 0 : 1);
+}
@@ -0,0 +1,265 @@
+#include <Arduino.h>
+#include <MD_OnePin_SimWire.h>
+#include <ucontext.h>
+
+/**
+ * \file
+ * \brief Code file for the simulated OnePin wire and virtual time Arduino functions.
+ *
+ * The SEC ISR runs on its own stack as a coroutine (ucontext). The main
+ * (PRI) context switches to it whenever the next SEC event, an ISR that
+ * is due or the end of a delay in the ISR, is before the end of the PRI
+ * wait in progress. The SEC context switches back when the ISR returns or
+ * it waits. Only one context runs at a time, so no locking is needed.
+ */
+
+#define NEVER UINT64_MAX    ///< no event time
+
+#define SIM_STACK_SIZE (64 * 1024)    ///< SEC context stack size
+
+// ---- Wire state
+typedef struct
+{
+  uint8_t mode;   ///< pinMode() setting
+  uint8_t out;    ///< output latch
+} simPin_t;
+
+static simConfig_t simCfg;
+static simStats_t simStat;
+static uint32_t simRnd = 1;       ///< random generator state
+
+static uint64_t timeNow = 0;      ///< virtual clock, ns
+static simPin_t pin[2];           ///< [0] PRI, [1] SEC
+static bool wireDriven = false;   ///< link pulled LOW by either side
+static uint64_t timeHigh = 0;     ///< time a released link reads HIGH
+
+// ---- SEC ISR context
+static void (*secIsr)(void) = nullptr;
+static ucontext_t ctxMain, ctxSec;
+static uint8_t secStack[SIM_STACK_SIZE];
+static bool inSec = false;        ///< the SEC context is running
+static bool secBusy = false;      ///< an ISR is in progress
+static uint64_t secWake = NEVER;  ///< end of the SEC delay in progress
+static uint64_t isrAt = NEVER;    ///< time the latched pin change ISR is due
+
+uint32_t simRandom(void)
+{
+  // xorshift32
+  simRnd ^= simRnd << 13;
+  simRnd ^= simRnd >> 17;
+  simRnd ^= simRnd << 5;
+
+  return(simRnd);
+}
+
+static uint32_t randomUpTo(uint32_t n)
+{
+  return(n == 0 ? 0 : simRandom() % (n + 1));
+}
+
+static void secMain(void)
+{
+  for (;;)
+  {
+    secBusy = true;
+    isrAt = NEVER;
+    simStat.isrRuns++;
+    secIsr();
+    secBusy = false;
+    swapcontext(&ctxSec, &ctxMain);
+  }
+}
+
+static uint64_t secNext(void)
+// time of the next SEC event
+{
+  if (secBusy) return(secWake);
+  return(isrAt);
+}
+
+static void waitUntil(uint64_t t)
+// move the clock on to t, running SEC events due on the way
+{
+  if (inSec)
+  {
+    // only the main context runs the other side, so hand back to it
+    secWake = t;
+    swapcontext(&ctxSec, &ctxMain);
+    secWake = NEVER;
+    return;
+  }
+
+  for (;;)
+  {
+    uint64_t next = secNext();
+
+    if (next > t) break;
+    if (next > timeNow) timeNow = next;
+    inSec = true;
+    swapcontext(&ctxMain, &ctxSec);
+    inSec = false;
+  }
+  if (t > timeNow) timeNow = t;
+}
+
+static bool pinDrivesLow(const simPin_t &p) { return(p.mode == OUTPUT && p.out == LOW); }
+static bool pinDrivesHigh(const simPin_t &p) { return(p.mode == OUTPUT && p.out == HIGH); }
+
+static bool wireLevel(void)
+{
+  return(!wireDriven && timeNow >= timeHigh);
+}
+
+static void wireUpdate(void)
+// work out the link level after a pin change and trigger the SEC ISR on an edge
+{
+  bool wasHigh = wireLevel();
+  bool low = pinDrivesLow(pin[0]) || pinDrivesLow(pin[1]);
+  uint64_t edge;
+
+  if (low && (pinDrivesHigh(pin[0]) || pinDrivesHigh(pin[1])))
+    simStat.contention++;
+
+  if (low == wireDriven) return;
+  wireDriven = low;
+
+  if (low)
+  {
+    if (!wasHigh) return;     // still rising from the last release
+    edge = timeNow;
+  }
+  else
+  {
+    // released, so rise with the pullup unless actively driven HIGH
+    timeHigh = timeNow;
+    if (!(pinDrivesHigh(pin[0]) || pinDrivesHigh(pin[1])))
+      timeHigh += simCfg.riseTime;
+    edge = timeHigh;
+  }
+  simStat.edges++;
+
+  // pin change interrupts are latched, so only the first edge is kept
+  if (secIsr != nullptr && isrAt == NEVER)
+    isrAt = edge + simCfg.secLatency + randomUpTo(simCfg.secJitter);
+}
+
+static simPin_t *pinFind(uint8_t p)
+{
+  if (p == SIM_PRI_PIN) return(&pin[0]);
+  if (p == SIM_SEC_PIN) return(&pin[1]);
+  return(nullptr);
+}
+
+static void ioCost(void)
+{
+  if (!inSec && simCfg.priIo != 0) waitUntil(timeNow + simCfg.priIo);
+}
+
+// ---- Simulator control
+void simBegin(const simConfig_t &cfg)
+{
+  simSetConfig(cfg);
+  simRnd = (cfg.seed == 0) ? 1 : cfg.seed;
+  memset(&simStat, 0, sizeof(simStat));
+  timeNow = timeHigh = 0;
+  wireDriven = false;
+  pin[0].mode = pin[1].mode = INPUT_PULLUP;
+  pin[0].out = pin[1].out = HIGH;
+  secIsr = nullptr;
+  secBusy = false;
+  secWake = isrAt = NEVER;
+}
+
+void simSetConfig(const simConfig_t &cfg)
+{
+  simCfg = cfg;
+}
+
+uint64_t simNow(void)
+{
+  return(timeNow);
+}
+
+const simStats_t &simGetStats(void)
+{
+  return(simStat);
+}
+
+// ---- Arduino functions
+void pinMode(uint8_t p, uint8_t mode)
+{
+  simPin_t *sp = pinFind(p);
+
+  if (sp == nullptr) return;
+  sp->mode = mode;
+  wireUpdate();
+  ioCost();
+}
+
+void digitalWrite(uint8_t p, uint8_t val)
+{
+  simPin_t *sp = pinFind(p);
+
+  if (sp == nullptr) return;
+  sp->out = val;
+  wireUpdate();
+  ioCost();
+}
+
+int digitalRead(uint8_t p)
+{
+  bool level = wireLevel();
+
+  if (pinFind(p) == nullptr) return(LOW);
+  ioCost();
+
+  return(level ? HIGH : LOW);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  uint64_t t = (uint64_t)us * 1000;
+
+  if (!inSec) t += randomUpTo(simCfg.priJitter);
+  waitUntil(timeNow + t);
+}
+
+void delay(unsigned long ms)
+{
+  waitUntil(timeNow + (uint64_t)ms * 1000000);
+}
+
+unsigned long micros(void)
+{
+  unsigned long t = (unsigned long)(timeNow / 1000);
+
+  // time moves on for a PRI polling loop
+  if (!inSec) waitUntil(timeNow + 100);
+
+  return(t);
+}
+
+unsigned long millis(void)
+{
+  return((unsigned long)(timeNow / 1000000));
+}
+
+void attachInterrupt(uint8_t irq, void (*isr)(void), int mode)
+{
+  (void)mode;   // always CHANGE
+
+  if (irq != SIM_SEC_PIN) return;
+  secIsr = isr;
+  getcontext(&ctxSec);
+  ctxSec.uc_stack.ss_sp = secStack;
+  ctxSec.uc_stack.ss_size = sizeof(secStack);
+  ctxSec.uc_link = nullptr;
+  makecontext(&ctxSec, secMain, 0);
+  secBusy = false;
+  secWake = isrAt = NEVER;
+}
+
+void detachInterrupt(uint8_t irq)
+{
+  if (irq == SIM_SEC_PIN) secIsr = nullptr;
+}
@@ -0,0 +1,85 @@
+#pragma once
+/**
+ * \file
+ * \brief Header for the simulated OnePin wire used by the host link simulator.
+ *
+ * The wire joins two pins, one used by PRI and one by SEC, as an open
+ * drain bus with a pullup resistor. The link is LOW if either side drives
+ * it LOW. When it is released by an open drain, the link rises to HIGH
+ * after the pullup rise time, unless a side actively drives it HIGH.
+ *
+ * PRI runs in the main program. The SEC pin change ISR runs as a separate
+ * context, switched in by the simulator when an edge is due to be seen by
+ * SEC. Both share the one virtual clock, which only moves on when a side
+ * waits (delayMicroseconds(), I/O and ISR latency), so the result of a
+ * run depends only on the settings and the random seed.
+ */
+
+#include <stdint.h>
+
+#define SIM_PRI_PIN 2   ///< pin used by PRI
+#define SIM_SEC_PIN 3   ///< pin used by SEC
+
+/**
+ * Simulated wire and processor timing.
+ *
+ * All times are in nanoseconds of virtual time.
+ */
+typedef struct
+{
+  uint32_t priIo;       ///< PRI time for each pinMode(), digitalWrite() and digitalRead()
+  uint32_t priJitter;   ///< up to this is randomly added to each PRI delayMicroseconds() (eg, interrupts)
+  uint32_t secLatency;  ///< time from an edge to the SEC ISR reading the timer
+  uint32_t secJitter;   ///< up to this is randomly added to the SEC ISR latency
+  uint32_t riseTime;    ///< time for the pullup to take a released link HIGH
+  uint32_t seed;        ///< random number seed
+} simConfig_t;
+
+/**
+ * Wire activity counters.
+ */
+typedef struct
+{
+  uint32_t edges;       ///< link level changes
+  uint32_t isrRuns;     ///< SEC ISR invocations
+  uint32_t contention;  ///< times one side drove the link HIGH while the other drove it LOW
+} simStats_t;
+
+/**
+ * Set up the simulated wire.
+ *
+ * Resets the virtual clock and the counters.
+ *
+ * \param cfg the wire and processor timing.
+ */
+void simBegin(const simConfig_t &cfg);
+
+/**
+ * Change the simulated timing.
+ *
+ * The clock and counters are not changed.
+ *
+ * \param cfg the wire and processor timing.
+ */
+void simSetConfig(const simConfig_t &cfg);
+
+/**
+ * Get the current virtual time.
+ *
+ * \return the time in nanoseconds since simBegin().
+ */
+uint64_t simNow(void);
+
+/**
+ * Get the wire activity counters.
+ *
+ * \return the counters since simBegin().
+ */
+const simStats_t &simGetStats(void);
+
+/**
+ * Get a pseudo random number from the simulator generator.
+ *
+ * \return the next random number.
+ */
+uint32_t simRandom(void);
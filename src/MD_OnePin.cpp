@@ -10,6 +10,9 @@ all the defined signals), and is implemented just using documented Arduino
 library calls (ie, no assembler, timer or other hardware specific features). 
 This library is designed to be portable across architectures.
 
+An optional direct port register I/O backend can be enabled by setting 
+OP_FAST_IO to 1 in MD_OnePin.h (see below).
+
 The SEC side is implemented as 'C' code that responds to the PRI signaling.
 The library's example SEC implementations detect and time the PRI initiating 
 signal using an Interrupt Service Routine (ISR), with most of the processing 
@@ -18,10 +21,52 @@ portable functions, but it is possible that for some applications a more low
 level approach may be required to implement the same, or similar, logic. 
 In other words, the SEC node is application dependent.
 
+The packaged SEC implementation in MD_OnePin_Sec.h and MD_OnePin_Sec.cpp 
+completes all the SEC signaling in the pin ISR (opsISR()), including the read 
+responses and presence signals, so the link timing does not depend on how busy 
+the application loop() is. The application reads the received packets from a 
+queue (opsAvailable(), opsRead()) and sets the data sent to PRI with 
+opsSetReply(), or queues a sequence of replies with opsQueueReply(). It 
+supports run time timeslot changes and test frames.
+
+The receive and reply queues are statically allocated lock-free single 
+producer/single consumer rings shared by the ISR and the main code without 
+disabling interrupts, so PRI can send packets back to back (eg, writeBuffer() 
+or write() with noReset) without packets being overwritten before the 
+application reads them. The sizes are set by OPS_RX_QUEUE_SIZE and 
+OPS_TX_QUEUE_SIZE, and opsRxLost() reports packets lost to a full queue.
+
+For very small SEC processors (eg, ATtiny13/85) MD_OnePin_SecTiny.h is a 
+minimal footprint SEC built for flash and RAM use rather than features. It 
+uses direct PORTB register I/O and the pin change interrupt, times signals 
+with the 8 bit Timer0 count already running for millis(), and classifies 
+them against 8 bit thresholds worked out from the OPT_*_DETECT values at 
+compile time. It supports the basic signals at the fixed T = OPT and has a 
+single packet mailbox. The RAM used is 14 bytes with the default packet 
+sizes, and static_assert checks that the timer can time the signals at OPT.
+
+With OPST_SLEEP set, a battery powered SEC calls opstSleep() in loop() to 
+sleep until the next interrupt. In idle mode Timer0 keeps running and the 
+SEC can sleep at any time. In power-down the clocks stop, so the SEC only 
+powers down with the link idle HIGH between signals. The falling edge of 
+the next signal (normally the Reset at the start of a transaction) wakes 
+it. The wake up time OPST_WAKE_US is added to that signal's duration in 
+the ISR, in whole timer ticks, so with the default 4&micro;s and 8&micro;s 
+Timer0 ticks nothing is added. The guarantee is a static_assert that the 
+wake up time is well inside the margin between the Reset signal and the 
+Read detection threshold, so even an uncompensated Reset is still 
+detected. millis() does not advance while powered down.
+
 The example SEC use an ISR tied to an external interrupt connected to PRI 
 digital I/O. However the same could work off other suitable interrupt types
 (eg, pin change interrupts).
 
+The resolution of the SEC signal timing limits how small T can be. On 16MHz 
+AVR processors micros() has a 4&micro;s resolution and disables interrupts while 
+it runs. MD_OnePin_SecTimer.h provides macros to use the ATmega 16 bit Timer1 
+as a free running timebase (0.5&micro;s resolution at 16MHz) read in the ISR. 
+The same macros fall back to micros() on unsupported hardware.
+
 As the two ends of the link both read and write on the same wire, PRI and 
 SEC orchestrate changing the I/O pin between INPUT and OUTPUT. These changes 
 are described in the section below.
@@ -42,6 +87,46 @@ functions. The PRI implementation measures an average value for these in
 begin() and adjusts timing parameters/delays when communicating to take 
 these into account.
 
+The measurement adds to the start up time and, timed with micros(), varies 
+a little from one start to the next. Where the processor has a cycle counter
+(OP_DEADLINE_TIMING) it is timed in clock ticks with interrupts off, which is
+quicker and repeatable. The calibration can also be skipped: 
+getCalibration() returns the values in use, which the application can save 
+(eg, in EEPROM) and pass to begin(const opCalib_t &) on the next start, or 
+the values for a board can be fixed at compile time by defining 
+OP_SWITCH_TIME and OP_WRITE_TIME in MD_OnePin.cpp.
+
+Setting OP_FAST_IO to 1 replaces these calls with direct operations on the
+port registers for the comms pin (AVR, SAMD, ESP32 and RP2040). The registers
+and bit mask are cached when the object is created, reducing each operation
+to a few processor cycles and making smaller values of T practical. Where the 
+hardware provides set/clear registers these are used, otherwise (AVR) the 
+read-modify-write is protected from interrupts. Note that SEC still limits how
+small T can be made.
+
+On processors with a free running cycle counter (DWT CYCCNT on Cortex-M3/M4/M7,
+the CPU cycle count on ESP32, the 1&micro;s system timer on RP2040) the waits 
+in each transaction count down to absolute deadlines from the start of the
+transaction (OP_DEADLINE_TIMING). The I/O overhead is then part of the time 
+waited rather than an estimate subtracted from each delay, so errors do not 
+accumulate over the bits in a packet and the delays cannot underflow when 
+the overhead exceeds a short wait. If a LOW signal starts late the deadlines
+are moved to the actual start so the signal is never shortened. Other 
+processors (eg, AVR) use delayMicroseconds() less the measured overhead, 
+clamped at 0.
+
+Interrupts serviced during a signal are another source of timing errors. 
+An ISR that runs while the link is LOW stretches the signal, and one that 
+runs between releasing the link and sampling it delays the sample. By 
+default (OP_IRQ_MASK in MD_OnePin.h) interrupts are masked from the start 
+of each LOW signal to the end of the signal or its sample, and enabled 
+again for the HIGH pause that completes the timeslot. Pending interrupts are 
+serviced in the pause, which absorbs them as SEC only times the LOW signals,
+so the link stays reliable at small T without holding off other ISRs for a
+whole packet. The longest masked time is the Sync or Reset signal and its
+presence sample. Non-blocking transactions are already timed by the Timer1
+interrupt and are not affected.
+
 Another source of potential issues are the timing gap between packet detection
 in SEC and the processing of the packet in the SEC loop(). For short T it is 
 possible that PRI has moved on through the signal before SEC has started its 
@@ -53,6 +138,269 @@ The base time slot T is defined as OPT and all other timing parameters are
 derived from this. Changing this single constant value is the correct way to 
 fine-tune timing related communications issues.
 
+Alternatively, for SEC that support it, T can be changed at run time using 
+setTimeslot(), or negotiated with negotiate(). Each MD_OnePin object keeps its
+own T and the timing parameters derived from it. negotiate() steps T down 
+from OPT by 1/8 of T at each step, and at each step uses test frames to write 
+and read back known data patterns. It settles on the smallest T where all the
+patterns are returned correctly. The MD_OnePin_Test_Sec example implements 
+the SEC side of this protocol.
+
+The relationship of each timing parameter to T is also available as a macro
+(eg, OPT_RST_SIGNAL_T(t)) to allow the timing to be derived for other values 
+of T. The MD_OnePinT class template (MD_OnePinT.h) uses these to provide a
+compile time variant of MD_OnePin where the pin, T and packet sizes are 
+template parameters. All the timing is then constant for each instance, the 
+bit loops are unrolled and several links with different T can be used from
+the same PRI.
+
+Overdrive is a high speed timeslot OPT_OD (about 10&micro;s) for bulk transfers
+with SEC that can support it. setOverdrive(true) changes to OPT_OD and checks
+it with test frames, restoring the previous T if the check fails. While in 
+overdrive, a Reset with no presence response drops the link back to OPT and 
+the Reset is retried, so a transaction that fails in overdrive is completed 
+at the default timeslot. The Sync signal is always sent at OPT, so the 
+fallback works even if signals at OPT_OD are not being received.
+
+Writes can optionally use 2 bit symbols (setEncoding(MD_OnePin::ENC_2BIT)), 
+where each write signal is one of four lengths and carries 2 bits of data. 
+This roughly halves the time to write a packet, but the smaller difference 
+between the signal lengths needs more accurate timing in SEC. The SEC must 
+be set up for the same encoding (eg, OPS_WRITE_2BIT for MD_OnePin_Sec). 
+Reads and the MD_OnePinT template always use the 1 bit signals, and 
+MD_OnePinGroup only runs writes in lockstep when all links use 1 bit encoding.
+
+An optional CRC-8 can be added to each packet with setCrc(true) to detect 
+corrupted bits. The receiving end ACKs or NAKs each packet in an extra slot, 
+and a NAKed packet is retried straight away (up to OP_CRC_RETRIES times, set
+in MD_OnePin.cpp) rather than the application repeating the whole 
+transaction from the Reset. isCrcOk() reports whether the last transaction 
+completed with good CRCs. The SEC must also support CRC (eg, OPS_CRC for 
+MD_OnePin_Sec). The CRC is a nibble table implementation to keep the flash 
+used small.
+
+## Write-Read Transactions
+A command followed by a response normally needs a write() and a read(), 
+each with its own Reset/Presence. transact() writes the command and reads 
+the reply in a single transaction. After the command packet (and its ACK 
+slot if CRC is used) PRI sends turnaround Read signals. SEC holds these LOW 
+while it is busy working out the reply and leaves the next one HIGH when the 
+reply is ready, so PRI only waits as long as needed (up to OP_BUSY_SLOTS 
+slots, set in MD_OnePin.cpp). The reply packet is then read as usual. 
+
+MD_OnePin_Sec can work out the reply in its ISR using a command handler 
+(opsSetCommandHandler()), which is never busy, or signal busy until the 
+application loop() sets the reply. negotiate() uses write-read transactions
+in the test frames.
+
+## Length-Prefixed Frames
+Packets are at most 32 bits, so larger blocks of data need several packets.
+writeFrame() and readFrame() instead send a Frame signal after the 
+Reset/Presence, then a length byte and up to 255 data bytes, so SEC can 
+store the bytes as they arrive. With CRC enabled one CRC-8 covers the whole
+frame. PRI checks that SEC supports frames from its response to the Frame 
+signal. MD_OnePin_Sec receives frames into an application buffer set with 
+opsSetRxFrame() and sends the buffer set with opsSetTxFrame().
+
+## SEC Attention Requests
+Only PRI can start a transaction, so without help PRI has to keep polling 
+SEC to find out if it has anything new. With setAttentionMode(true) PRI 
+leaves the link as an input between transactions and a SEC can send an 
+Attention signal (see \ref pageLinkSignals) when it wants to be read. 
+
+The application attaches a falling edge interrupt on the comms pin that calls
+attentionISR(), which ignores the PRI signals during transactions. 
+hasAttention() then reports whether SEC has asked for attention, and a 
+callback can also be set with setAttentionCallback(). PRI also catches an 
+Attention signal already in progress when it starts a transaction, and 
+hasAttention() checks the link level, so polling hasAttention() gives a slow 
+fallback without an interrupt. MD_OnePin_Sec sends Attention signals using 
+opsAttention().
+
+## Burst Transfers
+Each write() or read() normally starts with a Reset/Presence signal, which
+takes around 8T. When larger blocks of data are transferred, writeBuffer() and
+readBuffer() send a single Reset/Presence followed by a continuous stream of 
+bit signals for the whole buffer. 
+
+The buffer is streamed starting with the LSB of the first byte, so SEC sees 
+the stream as a sequence of consecutive packets (eg, for 32 bit PRI packets, 
+bytes 0-3 form the first packet with byte 0 as its least significant byte). 
+The last packet of a writeBuffer() is padded with 0 bits. SEC needs to restart 
+its bit count at the end of each complete packet, so that further bits are 
+accumulated into the next packet, and latch the next data to send at the 
+start of each packet it sends.
+
+readStream() is the packet equivalent of readBuffer(). It reads a number of
+whole packets after one Reset/Presence, and can carry on an unfinished 
+stream with noReset set. The packaged SEC pre-fetches the next queued reply 
+(opsQueueReply()) into its send register at the end of each packet it 
+sends, so the first Read signal of the next packet only has to send a bit. 
+An application that keeps the reply queue filled (eg, with sensor samples) 
+can then be read continuously at the full bit rate of the link.
+
+## Non-blocking Transactions
+The write() and read() methods block the PRI for the whole transaction. As an 
+alternative, startWrite() and startRead() set up the same transaction to be
+executed one signal edge at a time by runAsync(), returning immediately. 
+
+runAsync() performs the actions for the current edge (eg, pull the link LOW, 
+release the link, or sample the link) and returns the number of microseconds 
+until it needs to be called again. It is intended to be called from a hardware
+timer compare ISR that reloads the timer with this value, stopping when zero is
+returned. A callback function, set using setCallback(), is invoked when the 
+transaction has completed. Non-blocking transactions do not send or check 
+CRC, so they are not started when CRC is enabled with setCrc().
+
+The timer is application dependent and is set up by the application. For AVR 
+processors with a 16 bit Timer1 (eg, ATmega328P) setting OP_ASYNC_TIMER1 to 1
+in the library source file enables a built in Timer1 driver. Only one link at 
+a time can use the built in driver, and Timer1 is then not available for other
+uses (eg, Servo library, PWM on the associated pins).
+
+## Multiple Links
+A PRI connected to several SEC devices, each on its own pin, would normally 
+complete the transactions with each SEC one after the other. MD_OnePinGroup
+(MD_OnePinGroup.h) runs the transactions for a set of MD_OnePin links in 
+lockstep. Each signal edge is generated for all the links with one port 
+register write and the links are sampled with one port register read, so 
+the whole group takes about the same time as a single link.
+
+Lockstep operation requires OP_FAST_IO and all the links on the same I/O 
+port and at the same timeslot T. Links that have moved to different T (eg, 
+with negotiate() or MD_OnePinHealth) are run one after the other. In a 
+lockstep write, all links are pulled LOW together; links sending
+a 1 are released after OPT_WR1_SIGNAL and the rest after OPT_WR0_SIGNAL. SEC 
+only times the LOW part of the signal, so this is identical to the individual
+signals as seen by each SEC.
+
+broadcastWrite() sends the same packet to every link in the group, for 
+commands meant for all the SEC (eg, latch all outputs or set a common 
+rate). In lockstep the packet is sent once for all the links, so it takes 
+one packet time rather than N and all the SEC receive the last bit at the 
+same time. It returns true only if every SEC was present.
+
+SEC can also be wired in parallel on a single link, as the link is open 
+drain. Every SEC sees the same signals, so write() on that link is already 
+a broadcast. The Presence and Read responses are a wired-AND of the SEC 
+outputs: the link reads present if any SEC is present, and a read returns 
+the AND of the replies, so only writes are useful with parallel SEC. All 
+the parallel SEC need to use the same packet size and link settings.
+
+## Hardware Waveform Generation
+On ESP32 processors MD_OnePinRmt (MD_OnePinRmt.h) generates the link signals
+with the RMT peripheral rather than the CPU. Each signal is one RMT symbol, a
+LOW duration followed by a HIGH duration, so a whole transaction (eg, the 
+Reset signal and all the bits of a packet) is converted into a symbol buffer 
+that the RMT clocks out with 1&micro;s resolution and no CPU involvement.
+
+The pin is driven open drain and looped back to an RMT receive channel, 
+which captures the link waveform including the SEC presence and read 
+responses. The capture starts at the first falling edge, the start of the 
+first signal, and is sampled at the same points in the transaction at 
+which MD_OnePin samples the pin (eg, OPT_RD_SAMPLE after the end of each 
+Read signal). As SEC times the LOW part of each signal, the HIGH time 
+between transactions can be any length.
+
+The signal timing is then exact at any T and not affected by interrupts or 
+other tasks, so T is only limited by SEC. startWrite() and startRead() hand 
+the transaction to the RMT and return straight away, with the result passed
+to a callback when the capture completes. MD_OnePinRmt supports the same 
+write(), read() and setTimeslot() signals as MD_OnePin, without CRC, 
+write-read transactions, frames or attention mode.
+
+## Link Service Task
+On dual core ESP32 processors MD_OnePinService (MD_OnePinService.h) runs all 
+the transactions for a set of MD_OnePin links in a FreeRTOS task pinned to 
+the core not running the application, so the blocking link timing never 
+runs on the application core. The application queues write and read 
+requests with submitWrite() and submitRead(), which return straight away. 
+
+The requests are passed through a lock-free single producer/single consumer 
+ring of pointers to request structures owned by the application, and the 
+service task sleeps on a task notification while the ring is empty. Each 
+request works as a future: the service fills in the result and then sets 
+its done flag, and an optional callback is run from the service task. 
+
+Each transaction runs with the scheduler suspended on the service core, so 
+the FreeRTOS tick cannot switch tasks part way through a packet and push a
+sample past its time. Interrupts are still serviced as set by OP_IRQ_MASK.
+
+## Register Access
+MD_OnePinReg (MD_OnePinReg.h) reads and writes SEC registers by number 
+with writeReg(), readReg() and readRegs(), using the register protocol 
+described in \ref pageLinkSignals. The register number and operation go 
+in the top 8 bits of the PRI packet, so a device does not need its own 
+packet layout. A register read is one write-read transaction, and 
+readRegs() reads a block of registers after one Reset/Presence by 
+following the first reply with a readStream().
+
+The packaged SEC handles the register protocol in the ISR when it is given
+a register table with opsSetRegisters(). Each entry points to the 
+application variable holding the register, whether PRI can write it, and 
+an optional function called when it is written.
+
+## Link Health Monitor
+isPresent() and isCrcOk() only report the last transaction. MD_OnePinHealth
+(MD_OnePinHealth.h) keeps the results of the last 32 transactions on a link
+and changes T to suit the link. When too many transactions fail (no 
+presence or a CRC error) T is made 1/8 larger, and after a long run of 
+good transactions a T 1/8 smaller is checked with test frames and used if 
+it passes. If the smaller T then fails straight away the link goes back to
+the last good T and the monitor waits twice as long before trying again, so
+a marginal T is not retried often. A link that starts at OPT (or after 
+negotiate()) settles near the smallest T the wiring supports and follows 
+changes such as a degrading cable.
+
+Without CRC a corrupted write is not seen by PRI, so CRC should be enabled
+on links that use the monitor.
+
+## Link Statistics
+Setting OP_STATS to 1 in MD_OnePin.h enables statistics counters for each 
+link, retrieved with getStats() and reset with clearStats(). The counters 
+record the number of transactions, the data bits sent and received, the 
+Comms Reset signals with no presence response, the total time spent in 
+blocking transactions and the worst time a blocking transaction took over 
+its nominal signal time (eg, caused by interrupts or slow I/O). Unlike the 
+OP_DEBUG output and DBG_FLIP toggles, the counters do not noticeably change 
+the link timing so can be left enabled in production code.
+
+## Signal Trace
+Setting OP_TRACE to 1 in MD_OnePin.h (OPS_TRACE in MD_OnePin_Sec.h for SEC)
+records each signal in a small ring in memory. A record (opTrace_t in 
+MD_OnePin_Trace.h) holds the signal type and the measured LOW and HIGH 
+times, and for PRI the level sampled for Read and Presence. The ring keeps
+the most recent OP_TRACE_SIZE signals, so after a failed transaction it 
+holds the signals leading up to the failure. The records are read out one 
+at a time with readTrace() (opsTraceRead() for SEC).
+
+PRI records the time it actually took, which shows the stretching caused 
+by interrupts or slow I/O. SEC records the times it measured, and these 
+can be compared with the OPT_*_DETECT thresholds to find signals that are 
+close to being misread. Recording adds a few instructions to each signal 
+and uses 5 or 6 bytes of RAM for each record, so the ring sizes are best kept 
+small on AVR processors.
+
+## Benchmarking
+MD_OnePinBench (MD_OnePinBench.h) measures the performance of a link to 
+give repeatable numbers for comparing processors, cable lengths and I/O 
+backends. A benchmark run() completes a number of back to back write, read 
+or alternating transactions and reports the sustained data throughput, the 
+minimum, average, maximum and 99th percentile transaction times, and the 
+number of presence failures. A sweep() repeats this over a list of timeslot
+values, and the I/O calibration values measured in begin() are available
+with getSwitchTime() and getWriteTime(). The MD_OnePin_Test_Pri example 'bm'
+command runs a benchmark sweep.
+
+## Host Simulation
+The link simulator in the extras/sim folder builds the PRI and packaged SEC 
+code for a PC, using a replacement Arduino.h that runs the pins and timing 
+on a simulated wire in virtual time. Random packets are written and read 
+and checked, with settable I/O time, SEC ISR latency and random jitter on 
+both sides, so changes to the protocol timing can be checked for errors 
+and throughput over millions of packets and a range of T before they are 
+tried on hardware. See the README.md in that folder for details.
+
 Debugging two two sides of the link can be a bit tricky. The main reason for
 debugging is usually to determine the timing interaction between the two sides. 
 This means that any non-trivial debug output interfere with what is being 
@@ -103,6 +451,25 @@ timing values calculated in MD_OnePin_Protocol.h
 #define OP_DEBUG_DIGITAL 0      ///< 1 turns digital I/O debug output on
 #endif
 
+#ifndef OP_CRC_RETRIES
+#define OP_CRC_RETRIES 2    ///< number of times a packet is resent after a CRC error
+#endif
+
+#ifndef OP_BUSY_SLOTS
+#define OP_BUSY_SLOTS 64    ///< maximum turnaround slots PRI waits for a busy SEC in transact()
+#endif
+
+// Define OP_SWITCH_TIME and OP_WRITE_TIME together to fix the I/O calibration
+// (opCalib_t, in microseconds) for a board at compile time and skip the
+// measurement in begin().
+#if defined(OP_SWITCH_TIME) != defined(OP_WRITE_TIME)
+#error OP_SWITCH_TIME and OP_WRITE_TIME must be defined together
+#endif
+
+#ifndef OP_ASYNC_TIMER1
+#define OP_ASYNC_TIMER1 0   ///< 1 uses AVR Timer1 to drive non-blocking transactions
+#endif
+
 #if OP_DEBUG
 #define OPPRINT(s,v)   do { Serial.print(F(s)); Serial.print(v); } while (false)
 #define OPPRINTX(s,v)  do { Serial.print(F(s)); Serial.print(F("0x")); Serial.print(v, HEX); } while (false)
@@ -123,24 +490,180 @@ timing values calculated in MD_OnePin_Protocol.h
 // Define some macros
 // These are defined as macros to make the code inline and avoid a functional
 // call overhead in time critical sections
+#if OP_FAST_IO
+#define SET_TO_INPUT  opIoClr(_io.dir, _io.mask)
+#define SET_TO_OUTPUT opIoSet(_io.dir, _io.mask)
+#define PIN_SET_HIGH  opIoSet(_io.out, _io.mask)
+#define PIN_SET_LOW   opIoClr(_io.out, _io.mask)
+#define PIN_READ      ((*_io.in & _io.mask) ? HIGH : LOW)
+#else
 #define SET_TO_INPUT  pinMode(_pin, INPUT_PULLUP)
 #define SET_TO_OUTPUT pinMode(_pin, OUTPUT)
-#define OP_SIGNAL(active, pause) \
+#define PIN_SET_HIGH  digitalWrite(_pin, HIGH)
+#define PIN_SET_LOW   digitalWrite(_pin, LOW)
+#define PIN_READ      digitalRead(_pin)
+#endif
+
+// Statistics counters, compiled out unless OP_STATS is set
+#if OP_STATS
+#define STAT_BEGIN    do { _statStart = micros(); _statNominal = 0; } while (false)
+#define STAT_END      statEnd()
+#define STAT_INC(f)   (_stats.f++)
+#define STAT_ADD(f, n) (_stats.f += (n))
+#define STAT_NOMINAL(us) (_statNominal += (us))
+#else
+#define STAT_BEGIN       do {} while (false)
+#define STAT_END         do {} while (false)
+#define STAT_INC(f)      do {} while (false)
+#define STAT_ADD(f, n)   do { (void)(n); } while (false)
+#define STAT_NOMINAL(us) do {} while (false)
+#endif
+
+// Signal trace, compiled out unless OP_TRACE is set
+#if OP_TRACE
+#define TRACE_LOW(type)  traceLow(type)
+#define TRACE_HIGH       traceHigh()
+#define TRACE_SAMPLE(b)  traceSample(b)
+#if OP_DEADLINE_TIMING
+#define TRACE_NOW()      opClockNow()
+#define TRACE_US(ticks)  ((ticks) / OP_TICKS_PER_US)
+#else
+#define TRACE_NOW()      micros()
+#define TRACE_US(ticks)  (ticks)
+#endif
+#if (OP_TRACE_SIZE & (OP_TRACE_SIZE - 1)) != 0 || OP_TRACE_SIZE > 128
+#error OP_TRACE_SIZE must be a power of 2 no more than 128
+#endif
+#else
+#define TRACE_LOW(type)  do {} while (false)
+#define TRACE_HIGH       do {} while (false)
+#define TRACE_SAMPLE(b)  do {} while (false)
+#endif
+
+// Waits are timed to deadlines from the start of the transaction when the
+// processor supports it, otherwise compensated for the I/O overhead.
+#define OP_TIME_START opTimeStart(_deadline)
+#define OP_WAIT(us, comp) opTimeWait(_deadline, us, comp)
+
+// Interrupts are masked (OP_IRQ_MASK) for the LOW signal and any sample
+// that follows it, and enabled for the pause.
+#define OP_SIGNAL(type, active, pause) \
   do { \
-    digitalWrite(_pin, LOW);  \
-    delayMicroseconds(active - _writeTime); \
-    digitalWrite(_pin, HIGH); \
-    if (pause != 0) delayMicroseconds(pause - _writeTime); \
+    opIrqState_t irqSignal = opIrqSave(); \
+    opTimeCatchUp(_deadline); \
+    PIN_SET_LOW;  \
+    TRACE_LOW(type); \
+    OP_WAIT(active, _writeTime); \
+    PIN_SET_HIGH; \
+    TRACE_HIGH; \
+    opIrqRestore(irqSignal); \
+    if (pause != 0) OP_WAIT(pause, _writeTime); \
   } while (false)
 
-void MD_OnePin::begin(void)
+// Non-blocking transaction steps, in the order they are normally executed
+enum asyncState_t : uint8_t
 {
-  uint32_t start = micros();
+  AS_IDLE = 0,    // no transaction in progress, must be 0
+  AS_RST_START,   // start the reset signal
+  AS_RST_END,     // end the reset signal
+  AS_RST_SAMPLE,  // sample the presence signal
+  AS_BIT_START,   // start the bit signal
+  AS_BIT_END,     // end the bit signal
+  AS_RD_SAMPLE,   // sample the read bit
+  AS_DONE,        // transaction complete
+};
 
-  OPPRINT("\nBPPri:", _bppPri);
-  OPPRINT(" BPPSec:", _bppSec);
+#if OP_ASYNC_TIMER1
+#if !defined(ARDUINO_ARCH_AVR) || !defined(TIMSK1) || !defined(OCIE1A)
+#error OP_ASYNC_TIMER1 needs an AVR processor with a 16 bit Timer1
+#endif
+
+// The MD_OnePin object currently using Timer1 (nullptr if none)
+static MD_OnePin * volatile asyncLink = nullptr;
+
+// Timer1 runs in CTC mode with a prescaler of 8. The period
+// is OCR1A+1 timer ticks.
+#define T1_OCR(us) ((uint16_t)((((uint32_t)(us) * (F_CPU / 1000000UL)) >> 3) - 1))
+
+ISR(TIMER1_COMPA_vect)
+{
+  uint16_t next = asyncLink->runAsync();
+
+  if (next != 0)
+    OCR1A = T1_OCR(next);
+  else
+  {
+    TCCR1B = 0;                 // stop the timer
+    TIMSK1 &= ~_BV(OCIE1A);
+    asyncLink = nullptr;
+  }
+}
+#endif
+
+// Data patterns sent in test frame transactions to check a timeslot. 
+// Alternating bits exercise the most signal transitions.
+static const MD_OnePin::packet_t testPattern[] = { 0x55555555, 0xaaaaaaaa, 0x0ff00ff0 };
+const uint8_t TEST_PASSES = 2;    // test frames needed at a timeslot to pass
+
+void MD_OnePin::setTiming(uint16_t t)
+{
+  _tm.t = t;
+  _tm.rstSignal = OPT_RST_SIGNAL_T(t);
+  _tm.rstPrsSample = OPT_RST_PRS_SAMPLE_T(t);
+  _tm.rstEnd = OPT_RST_END_T(t);
+  _tm.wr1Signal = OPT_WR1_SIGNAL_T(t);
+  _tm.wr1Pause = OPT_WR1_PAUSE_T(t);
+  _tm.wr0Signal = OPT_WR0_SIGNAL_T(t);
+  _tm.wr0Pause = OPT_WR0_PAUSE_T(t);
+  _tm.rdInit = OPT_RD_INIT_T(t);
+  _tm.rdSample = OPT_RD_SAMPLE_T(t);
+  _tm.rdPause = OPT_RD_PAUSE_T(t);
+  for (uint8_t i = 0; i < 4; i++)
+    _tm.symSignal[i] = OPT_SYM_SIGNAL_T(t, i);
+  _tm.symPause = OPT_SYM_PAUSE_T(t);
+  _tm.frmSignal = OPT_FRM_SIGNAL_T(t);
+}
+
+opCalib_t MD_OnePin::calibrate(void)
+{
+  opCalib_t cal;
+
+#if OP_FAST_IO
+  // let the core set up pin multiplexing and pullups, as from
+  // here on only the direction and output bits are changed
+  pinMode(_pin, INPUT_PULLUP);
+#endif
+
+#if OP_DEADLINE_TIMING
+  // Count clock ticks with interrupts off, so a few operations 
+  // give an accurate and repeatable average.
+  opTick_t start;
+
+  opClockBegin();
+  noInterrupts();
+  start = opClockNow();
+  for (uint8_t i = 0; i < 16; i++)
+  {
+    // Note we are switching 2x in this loop!
+    SET_TO_OUTPUT;
+    SET_TO_INPUT;
+  }
+  cal.switchTime = (opClockNow() - start) / (32 * OP_TICKS_PER_US);
+
+  SET_TO_OUTPUT;
+
+  start = opClockNow();
+  for (uint8_t i = 0; i < 16; i++)
+  {
+    PIN_SET_HIGH;
+    PIN_SET_LOW;
+  }
+  cal.writeTime = (opClockNow() - start) / (32 * OP_TICKS_PER_US);
+  interrupts();
+#else
+  uint32_t start = micros();
 
-  // work out average time for a SET_TO_* and digitalWrite() 
+  // work out average time for a SET_TO_* and PIN_SET_* 
   // micros() is not especially accurate for short times, so accumulate a number of
   // SET_TO_* operations and average out the larger number.
   // Use a power of 2 count so we can easily divide the delta time (below).
@@ -150,8 +673,7 @@ void MD_OnePin::begin(void)
     SET_TO_OUTPUT;
     SET_TO_INPUT;
   }
-  _switchTime = (micros() - start) >> 7; // divide by 2 * (loop count's power of 2) 
-  OPPRINT("\nAvg switch us: ", _switchTime);
+  cal.switchTime = (micros() - start) >> 7; // divide by 2 * (loop count's power of 2) 
 
   SET_TO_OUTPUT;
 
@@ -159,14 +681,45 @@ void MD_OnePin::begin(void)
   for (uint8_t i = 0; i < 128; i++)
   {
     // Note we are switching 2x in this loop!
-    digitalWrite(_pin, HIGH);
-    digitalWrite(_pin, LOW);
+    PIN_SET_HIGH;
+    PIN_SET_LOW;
   }
-  _writeTime = (micros() - start) >> 8; // divide by 2 * (loop count's power of 2)
+  cal.writeTime = (micros() - start) >> 8; // divide by 2 * (loop count's power of 2)
+#endif
+
+  return(cal);
+}
+
+void MD_OnePin::begin(void)
+{
+#if defined(OP_SWITCH_TIME) && defined(OP_WRITE_TIME)
+  opCalib_t cal = { OP_SWITCH_TIME, OP_WRITE_TIME };
+#else
+  opCalib_t cal = calibrate();
+#endif
+
+  begin(cal);
+}
+
+void MD_OnePin::begin(const opCalib_t &cal)
+{
+  OPPRINT("\nBPPri:", _bppPri);
+  OPPRINT(" BPPSec:", _bppSec);
+
+#if OP_FAST_IO
+  pinMode(_pin, INPUT_PULLUP);
+#endif
+
+  _switchTime = cal.switchTime;
+  _writeTime = cal.writeTime;
+  OPPRINT("\nAvg switch us: ", _switchTime);
   OPPRINT("\nAvg write us: ", _writeTime);
 
   // set up the actual initial config for the comms pin
-  digitalWrite(_pin, HIGH);
+  PIN_SET_HIGH;
+  SET_TO_OUTPUT;
+  if (_attnMode) SET_TO_INPUT;
+  opClockBegin();
 
   // if debugging, initialize the debug output pin
 #if OP_DEBUG_DIGITAL
@@ -175,59 +728,781 @@ void MD_OnePin::begin(void)
 #endif
 }
 
+inline void MD_OnePin::sendBit(bool b)
+{
+  if (b) OP_SIGNAL(OPTR_WR1, _tm.wr1Signal, _tm.wr1Pause);
+  else   OP_SIGNAL(OPTR_WR0, _tm.wr0Signal, _tm.wr0Pause);
+  DBG_FLIP;   // bit sent
+  STAT_INC(bitsSent);
+  STAT_NOMINAL(b ? _tm.wr1Signal + _tm.wr1Pause : _tm.wr0Signal + _tm.wr0Pause);
+}
+
+inline void MD_OnePin::sendSymbol(uint8_t s, uint8_t bits)
+{
+  OP_SIGNAL(OPTR_SYM0 + s, _tm.symSignal[s], _tm.symPause);
+  DBG_FLIP;   // symbol sent
+  STAT_ADD(bitsSent, bits);
+  STAT_NOMINAL(_tm.symSignal[s] + _tm.symPause);
+}
+
+inline void MD_OnePin::sendBits(packet_t data, uint8_t bits)
+{
+  // send out each bit or symbol in turn, LSB first
+  if (_encoding == ENC_2BIT)
+  {
+    for (uint8_t i = 0; i < bits; i += 2, data >>= 2)
+    {
+      if (bits - i == 1)    // odd bit count, the last symbol carries 1 bit
+        sendSymbol(data & 1, 1);
+      else
+        sendSymbol(data & 3, 2);
+    }
+  }
+  else
+  {
+    for (uint8_t i = 0; i < bits; i++, data >>= 1)
+      sendBit(data & 1);
+  }
+}
+
+inline bool MD_OnePin::recvBit(void)
+{
+  bool b;
+  opIrqState_t irq = opIrqSave();
+
+  OP_SIGNAL(OPTR_READ, _tm.rdInit, 0);
+  SET_TO_INPUT;
+  OP_WAIT(_tm.rdSample, _switchTime);
+  b = (PIN_READ == HIGH);
+  TRACE_SAMPLE(b);
+  SET_TO_OUTPUT;
+  opIrqRestore(irq);
+  DBG_FLIP;   // bit received/sampled
+  OP_WAIT(_tm.rdPause, _switchTime);
+  STAT_INC(bitsRecv);
+  STAT_NOMINAL(_tm.rdInit + _tm.rdSample + _tm.rdPause);
+
+  return(b);
+}
+
+#if OP_TRACE
+inline void MD_OnePin::traceLow(uint8_t type)
+{
+  uint32_t now = TRACE_NOW();
+  opTrace_t &rec = _trace[_traceHead];
+
+  rec.type = type;
+  rec.high = opTraceTime(TRACE_US(now - _traceEdge));
+  _traceEdge = now;
+}
+
+inline void MD_OnePin::traceHigh(void)
+{
+  uint32_t now = TRACE_NOW();
+
+  _trace[_traceHead].low = opTraceTime(TRACE_US(now - _traceEdge));
+  _traceEdge = now;
+  _traceHead = (_traceHead + 1) & (OP_TRACE_SIZE - 1);
+  if (_traceCount < OP_TRACE_SIZE) _traceCount++;   // otherwise the oldest is overwritten
+}
+
+inline void MD_OnePin::traceSample(bool high)
+{
+  if (high) _trace[(_traceHead - 1) & (OP_TRACE_SIZE - 1)].type |= OPTR_SAMPLE_HIGH;
+}
+
+bool MD_OnePin::readTrace(opTrace_t &rec)
+{
+  if (_traceCount == 0) return(false);
+
+  rec = _trace[(_traceHead - _traceCount) & (OP_TRACE_SIZE - 1)];
+  _traceCount--;
+
+  return(true);
+}
+#endif
+
+inline void MD_OnePin::linkStart(void)
+{
+  _linkBusy = _linkBusy + 1;
+  if (_linkBusy != 1 || !_attnMode) return;
+
+  // An Attention signal already started by SEC is counted and 
+  // allowed to finish before PRI drives the link.
+  if (PIN_READ == LOW)
+  {
+    uint32_t start = micros();
+
+    _attn = true;
+    while (PIN_READ == LOW && micros() - start < OPT_ATN_SIGNAL_T(_tm.t))
+      ;   // wait for SEC to release the link
+  }
+  PIN_SET_HIGH;
+  SET_TO_OUTPUT;
+}
+
+inline void MD_OnePin::linkEnd(void)
+{
+  if (_linkBusy != 0) _linkBusy = _linkBusy - 1;
+
+  // in attention mode the link is left pulled HIGH for SEC to use
+  if (_linkBusy == 0 && _attnMode) SET_TO_INPUT;
+}
+
+inline uint8_t MD_OnePin::recvByte(void)
+{
+  uint8_t b = 0;
+
+  for (uint8_t i = 0; i < 8; i++)
+    if (recvBit()) b |= (1 << i);
+
+  return(b);
+}
+
+bool MD_OnePin::writePacket(packet_t data)
+{
+  bool ack = true;
+
+  if (_bppPri < 32) data &= ((packet_t)1 << _bppPri) - 1;
+
+  if (!_crc)
+    sendBits(data, _bppPri);
+  else
+  {
+    uint8_t crc = opCrc8Packet(data, _bppPri);
+
+    // Send the packet and CRC, then SEC pulls the link LOW in the
+    // following read slot to ACK. Retry straight away on a NAK.
+    for (uint8_t retry = 0; ; retry++)
+    {
+      sendBits(data, _bppPri);
+      sendBits(crc, 8);
+      ack = !recvBit();
+      if (ack || retry == OP_CRC_RETRIES) break;
+      STAT_INC(crcErrors);
+    }
+    if (!ack) STAT_INC(crcErrors);
+  }
+
+  return(ack);
+}
+
+MD_OnePin::packet_t MD_OnePin::readPacket(bool &ok)
+{
+  packet_t packet;
+
+  // Read the packet and CRC, then ACK with a 1 or NAK with a 0 so
+  // that SEC sends the packet again. Retry straight away on a NAK.
+  for (uint8_t retry = 0; ; retry++)
+  {
+    packet_t mask = 1;
+
+    packet = 0;
+    for (uint8_t i = 0; i < _bppSec; i++, mask <<= 1)
+      if (recvBit()) packet |= mask;
+    if (!_crc) break;
+
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < 8; i++)
+      if (recvBit()) crc |= (1 << i);
+    ok = (crc == opCrc8Packet(packet, _bppSec));
+    sendBits(ok, 1);
+    if (ok || retry == OP_CRC_RETRIES) break;
+    STAT_INC(crcErrors);
+  }
+  if (!ok) STAT_INC(crcErrors);
+
+  return(packet);
+}
+
 bool MD_OnePin::write(packet_t data, bool noReset)
 {
+  STAT_BEGIN;
+  linkStart();
+  OP_TIME_START;
+  _crcOk = true;
+  if (!noReset) resetComm();
+
+  if (noReset || _presence)
+    _crcOk = writePacket(data);
+  STAT_END;
+  linkEnd();
+
+  return(_presence && _crcOk);
+}
+
+MD_OnePin::packet_t MD_OnePin::read(bool noReset)
+{
+  packet_t packet;
+
+  STAT_BEGIN;
+  linkStart();
+  OP_TIME_START;
+  _crcOk = true;
+  if (!noReset) resetComm();
+
+  if (!noReset && !_presence) 
+  {
+    STAT_END;
+    linkEnd();
+    return (0xffffffff);
+  }
+
+  packet = readPacket(_crcOk);
+  STAT_END;
+  linkEnd();
+
+  return(packet);
+}
+
+bool MD_OnePin::transact(packet_t cmd, packet_t &reply, bool noReset)
+{
+  bool ready = false;
+
+  STAT_BEGIN;
+  linkStart();
+  OP_TIME_START;
+  _crcOk = true;
+  reply = 0xffffffff;
   if (!noReset) resetComm();
 
   if (noReset || _presence)
   {
-    // send out each bit in turn, LSB first
-    for (uint8_t i = 0; i < _bppPri; i++, data >>= 1)
+    _crcOk = writePacket(cmd);
+    if (_crcOk)
     {
-      if (data & 1) OP_SIGNAL(OPT_WR1_SIGNAL, OPT_WR1_PAUSE);
-      else          OP_SIGNAL(OPT_WR0_SIGNAL, OPT_WR0_PAUSE);
-      DBG_FLIP;   // bit received/sampled
+      // Turnaround slots, SEC holds these LOW while it works out the reply
+      for (uint16_t i = 0; i < OP_BUSY_SLOTS && !ready; i++)
+        ready = recvBit();
+      if (ready) reply = readPacket(_crcOk);
     }
   }
+  STAT_END;
+  linkEnd();
 
-  return(_presence);
+  return((noReset || _presence) && _crcOk && ready);
 }
 
-MD_OnePin::packet_t MD_OnePin::read(bool noReset)
+bool MD_OnePin::writeFrame(const uint8_t *buf, uint8_t len)
+{
+  bool ok = false;
+
+  STAT_BEGIN;
+  linkStart();
+  OP_TIME_START;
+  _crcOk = true;
+
+  if (frameStart())
+  {
+    uint8_t crc = opCrc8(0, len);
+
+    sendBits(len, 8);
+    for (uint8_t i = 0; i < len; i++)
+    {
+      sendBits(buf[i], 8);
+      crc = opCrc8(crc, buf[i]);
+    }
+    ok = true;
+    if (_crc)
+    {
+      sendBits(crc, 8);
+      _crcOk = ok = !recvBit();   // SEC ACK is a 0
+      if (!ok) STAT_INC(crcErrors);
+    }
+  }
+  STAT_END;
+  linkEnd();
+
+  return(ok);
+}
+
+bool MD_OnePin::readFrame(uint8_t *buf, uint8_t size, uint8_t &len)
+{
+  bool ok = false;
+
+  STAT_BEGIN;
+  linkStart();
+  OP_TIME_START;
+  _crcOk = true;
+  len = 0;
+
+  if (frameStart())
+  {
+    uint8_t crc;
+
+    len = recvByte();
+    crc = opCrc8(0, len);
+    for (uint8_t i = 0; i < len; i++)
+    {
+      uint8_t b = recvByte();
+
+      if (i < size) buf[i] = b;
+      crc = opCrc8(crc, b);
+    }
+    ok = true;
+    if (_crc)
+    {
+      _crcOk = ok = (recvByte() == crc);
+      if (!ok) STAT_INC(crcErrors);
+    }
+  }
+  STAT_END;
+  linkEnd();
+
+  return(ok);
+}
+
+bool MD_OnePin::writeBuffer(const uint8_t *buf, size_t len)
+{
+  STAT_BEGIN;
+  linkStart();
+  OP_TIME_START;
+  _crcOk = true;
+  resetComm();
+
+  if (_presence)
+  {
+    // Stream all the bits, LSB of each byte first, padding the 
+    // last packet with 0 so that SEC receives complete packets.
+    uint32_t bits = (uint32_t)len * 8;
+
+    for (uint32_t i = 0; i < bits; i += _bppPri)
+    {
+      packet_t data = 0;
+
+      for (uint8_t j = 0; j < _bppPri && i + j < bits; j++)
+        if (buf[(i + j) >> 3] & (1 << ((i + j) & 7))) 
+          data |= ((packet_t)1 << j);
+      if (!writePacket(data)) _crcOk = false;
+    }
+  }
+  STAT_END;
+  linkEnd();
+
+  return(_presence && _crcOk);
+}
+
+bool MD_OnePin::readBuffer(uint8_t *buf, size_t len)
 {
-  uint32_t packet = 0;
-  packet_t mask = 1;
+  STAT_BEGIN;
+  linkStart();
+  OP_TIME_START;
+  _crcOk = true;
+  resetComm();
+
+  memset(buf, _presence ? 0 : 0xff, len);
+  if (_presence)
+  {
+    // Stream all the bits, LSB of each byte first
+    uint32_t bits = (uint32_t)len * 8;
 
+    if (!_crc)
+    {
+      for (uint32_t i = 0; i < bits; i++)
+        if (recvBit()) buf[i >> 3] |= (1 << (i & 7));
+    }
+    else
+    {
+      // Each packet is checked, so read whole packets
+      for (uint32_t i = 0; i < bits; i += _bppSec)
+      {
+        bool ok = true;
+        packet_t data = readPacket(ok);
+
+        if (!ok) _crcOk = false;
+        for (uint8_t j = 0; j < _bppSec && i + j < bits; j++)
+          if (data & ((packet_t)1 << j))
+            buf[(i + j) >> 3] |= (1 << ((i + j) & 7));
+      }
+    }
+  }
+  STAT_END;
+  linkEnd();
+
+  return(_presence && _crcOk);
+}
+
+bool MD_OnePin::readStream(packet_t *buf, uint16_t count, bool noReset)
+{
+  STAT_BEGIN;
+  linkStart();
+  OP_TIME_START;
+  _crcOk = true;
   if (!noReset) resetComm();
 
-  if (!noReset && !_presence) return (0xffffffff);
+  for (uint16_t i = 0; i < count; i++)
+  {
+    bool ok = true;
+
+    if (!noReset && !_presence)
+      buf[i] = 0xffffffff;
+    else
+    {
+      buf[i] = readPacket(ok);
+      if (!ok) _crcOk = false;
+    }
+  }
+  STAT_END;
+  linkEnd();
+
+  return((noReset || _presence) && _crcOk);
+}
+
+bool MD_OnePin::resetComm(void)
+{
+  opIrqState_t irq = opIrqSave();
+
+  SET_TO_OUTPUT;
+  OP_SIGNAL(OPTR_RESET, _tm.rstSignal, 0);
+  SET_TO_INPUT;
+  OP_WAIT(_tm.rstPrsSample, _switchTime);
+  DBG_FLIP; // sampling point
+  _presence = (PIN_READ == LOW);
+  TRACE_SAMPLE(!_presence);
+  SET_TO_OUTPUT;
+  opIrqRestore(irq);
+  OP_WAIT(_tm.rstEnd, _switchTime);
+  DBG_FLIP; // end of signal
+  STAT_NOMINAL(_tm.rstSignal + _tm.rstPrsSample + _tm.rstEnd);
+  if (!_presence) STAT_INC(presenceFail);
+
+  // A failure in overdrive drops back to the default timeslot and tries 
+  // again. This Reset also ends the test frame started by the change.
+  if (!_presence && _overdrive && odFallback()) resetComm();
+
+  return(_presence);
+}
+
+bool MD_OnePin::frameStart(void)
+{
+  bool frames;
+  opIrqState_t irq;
+
+  if (!resetComm()) return(false);
+
+  // SEC that supports frames leaves the link HIGH after the Frame
+  // signal, others see a Reset signal and signal their presence.
+  irq = opIrqSave();
+  OP_SIGNAL(OPTR_FRAME, _tm.frmSignal, 0);
+  SET_TO_INPUT;
+  OP_WAIT(_tm.rstPrsSample, _switchTime);
+  frames = (PIN_READ == HIGH);
+  TRACE_SAMPLE(frames);
+  SET_TO_OUTPUT;
+  opIrqRestore(irq);
+  OP_WAIT(_tm.rstEnd, _switchTime);
+  STAT_NOMINAL(_tm.frmSignal + _tm.rstPrsSample + _tm.rstEnd);
+  OPPRINT("\nFrames: ", frames);
+
+  return(frames);
+}
+
+#if OP_STATS
+void MD_OnePin::statEnd(void)
+{
+  uint32_t elapsed = micros() - _statStart;
+
+  _stats.transactions++;
+  _stats.usBlocked += elapsed;
+  if (elapsed > _statNominal)
+  {
+    uint32_t over = elapsed - _statNominal;
+
+    if (over > 0xffff) over = 0xffff;
+    if (over > _stats.maxOverrun) _stats.maxOverrun = over;
+  }
+}
+#endif
+
+void MD_OnePin::setAttentionMode(bool on)
+{
+  _attnMode = on;
+  _attn = false;
+  if (_linkBusy == 0)
+  {
+    if (on) SET_TO_INPUT;
+    else
+    {
+      PIN_SET_HIGH;
+      SET_TO_OUTPUT;
+    }
+  }
+}
+
+bool MD_OnePin::hasAttention(void)
+{
+  bool a;
+  opIrqState_t irq = opIrqLock();   // _attn is also set by attentionISR()
+
+  if (_attnMode && _linkBusy == 0 && PIN_READ == LOW) _attn = true;
+  a = _attn;
+  _attn = false;
+  opIrqUnlock(irq);
+
+  return(a);
+}
+
+void MD_OnePin::attentionISR(void)
+{
+  // anything while a transaction is running is a PRI signal
+  if (!_attnMode || _linkBusy != 0) return;
+
+  _attn = true;
+  if (_cbAttention != nullptr) _cbAttention(this);
+}
+
+bool MD_OnePin::startAsync(bool isRead, packet_t data, bool noReset)
+{
+#if OP_ASYNC_TIMER1
+  // if we are being called from the completion callback this 
+  // link already owns the timer, otherwise it must be free
+  bool inISR = (asyncLink == this);
 
-  // receive each bit in turn, LSB first
-  for (uint8_t i = 0; i < _bppSec; i++, mask <<= 1)
+  if (!inISR && asyncLink != nullptr) return(false);
+#endif
+  if (isBusy() || _crc) return(false);    // non-blocking transactions have no CRC
+
+  _asyncRead = isRead;
+  _asyncData = data;
+  _asyncBit = 0;
+  _asyncState = noReset ? AS_BIT_START : AS_RST_START;
+  linkStart();
+  if (noReset) SET_TO_OUTPUT;
+
+#if OP_ASYNC_TIMER1
+  if (!inISR)
   {
-    OP_SIGNAL(OPT_RD_INIT, 0);
+    asyncLink = this;
+    TCCR1A = 0;
+    TCCR1B = _BV(WGM12);        // CTC mode, timer stopped
+    TCNT1 = 0;
+    OCR1A = T1_OCR(runAsync()); // first edge now
+    TIFR1 = _BV(OCF1A);         // clear any pending interrupt
+    TIMSK1 |= _BV(OCIE1A);
+    TCCR1B = _BV(WGM12) | _BV(CS11);  // start with prescaler 8
+  }
+#endif
+
+  return(true);
+}
+
+bool MD_OnePin::startWrite(packet_t data, bool noReset)
+{
+  return(startAsync(false, data, noReset));
+}
+
+bool MD_OnePin::startRead(bool noReset)
+{
+  return(startAsync(true, 0, noReset));
+}
+
+uint16_t MD_OnePin::runAsync(void)
+{
+  uint16_t next = 0;
+
+  // Each step performs the actions for one signal edge, sets up 
+  // the next step and returns the time to the next edge.
+  switch (_asyncState)
+  {
+  case AS_IDLE:
+    break;
+
+  case AS_RST_START:
+    SET_TO_OUTPUT;
+    PIN_SET_LOW;
+    _asyncState = AS_RST_END;
+    next = _tm.rstSignal;
+    break;
+
+  case AS_RST_END:
+    PIN_SET_HIGH;
     SET_TO_INPUT;
-    delayMicroseconds(OPT_RD_SAMPLE - _switchTime);
-    if (digitalRead(_pin) == HIGH) packet |= mask;
+    _asyncState = AS_RST_SAMPLE;
+    next = _tm.rstPrsSample;
+    break;
+
+  case AS_RST_SAMPLE:
+    DBG_FLIP; // sampling point
+    _presence = (PIN_READ == LOW);
+    SET_TO_OUTPUT;
+    if (_presence)
+      _asyncState = AS_BIT_START;
+    else
+    {
+      STAT_INC(presenceFail);
+      if (_asyncRead) _asyncData = 0xffffffff;
+      _asyncState = AS_DONE;
+    }
+    next = _tm.rstEnd;
+    break;
+
+  case AS_BIT_START:
+    PIN_SET_LOW;
+    _asyncState = AS_BIT_END;
+    if (_asyncRead)
+      next = _tm.rdInit;
+    else if (_encoding == ENC_2BIT)
+      next = _tm.symSignal[(_asyncData >> _asyncBit) & (_bppPri - _asyncBit == 1 ? 1 : 3)];
+    else
+      next = (_asyncData & ((packet_t)1 << _asyncBit)) ? _tm.wr1Signal : _tm.wr0Signal;
+    break;
+
+  case AS_BIT_END:
+    PIN_SET_HIGH;
+    if (_asyncRead)
+    {
+      SET_TO_INPUT;
+      _asyncState = AS_RD_SAMPLE;
+      next = _tm.rdSample;
+    }
+    else
+    {
+      DBG_FLIP;   // bit sent
+      if (_encoding == ENC_2BIT)
+      {
+        uint8_t n = (_bppPri - _asyncBit == 1) ? 1 : 2;
+
+        STAT_ADD(bitsSent, n);
+        next = _tm.symPause;
+        _asyncBit += n;
+      }
+      else
+      {
+        STAT_INC(bitsSent);
+        next = (_asyncData & ((packet_t)1 << _asyncBit)) ? _tm.wr1Pause : _tm.wr0Pause;
+        _asyncBit++;
+      }
+      _asyncState = (_asyncBit < _bppPri) ? AS_BIT_START : AS_DONE;
+    }
+    break;
+
+  case AS_RD_SAMPLE:
+    if (PIN_READ == HIGH) _asyncData |= ((packet_t)1 << _asyncBit);
     SET_TO_OUTPUT;
     DBG_FLIP;   // bit received/sampled
-    delayMicroseconds(OPT_RD_PAUSE - _switchTime);
+    STAT_INC(bitsRecv);
+    next = _tm.rdPause;
+    _asyncBit++;
+    _asyncState = (_asyncBit < _bppSec) ? AS_BIT_START : AS_DONE;
+    break;
+
+  case AS_DONE:
+    _asyncState = AS_IDLE;
+    linkEnd();
+    STAT_INC(transactions);
+    if (_cbComplete != nullptr) _cbComplete(this, _asyncData);
+    // the callback may have started a new transaction, so run that straight away
+    if (isBusy()) next = 1;
+    break;
   }
 
-  return(packet);
+  return(next);
 }
 
-bool MD_OnePin::resetComm(void)
+bool MD_OnePin::setTimeslot(uint16_t t)
 {
+  uint16_t tPrev = _tm.t;
+  opIrqState_t irq;
+
+  // SEC sees a Reset longer than OPT_SYNC_DETECT as a Sync
+  if (t < OPT_MIN || t > OPT_MAX) return(false);
+
+  // The Sync signal always uses the default timing
+  linkStart();
+  OP_TIME_START;
+  irq = opIrqSave();
   SET_TO_OUTPUT;
-  OP_SIGNAL(OPT_RST_SIGNAL, 0);
+  OP_SIGNAL(OPTR_SYNC, OPT_SYNC_SIGNAL, 0);
   SET_TO_INPUT;
-  delayMicroseconds(OPT_RST_PRS_SAMPLE - _switchTime);
-  DBG_FLIP; // sampling point
-  _presence = (digitalRead(_pin) == LOW);
+  OP_WAIT(OPT_RST_PRS_SAMPLE, _switchTime);
+  _presence = (PIN_READ == LOW);
+  TRACE_SAMPLE(!_presence);
   SET_TO_OUTPUT;
-  delayMicroseconds(OPT_RST_END - _switchTime);
-  DBG_FLIP; // end of signal
+  opIrqRestore(irq);
+  OP_WAIT(OPT_RST_END, _switchTime);
+
+  // now the Reset at the new timeslot, if SEC is there. If SEC does 
+  // not accept the new T it stays at the old one, and so does PRI.
+  if (_presence)
+  {
+    setTiming(t);
+    resetComm();
+    if (_presence)
+    {
+      _overdrive = false;
+      OPPRINT("\nTimeslot: ", t);
+    }
+    else
+      setTiming(tPrev);
+  }
+  linkEnd();
 
   return(_presence);
 }
+
+bool MD_OnePin::testTimeslot(uint16_t t)
+{
+  packet_t mask = (_bppSec >= 32) ? 0xffffffff : (((packet_t)1 << _bppSec) - 1);
+
+  for (uint8_t pass = 0; pass < TEST_PASSES; pass++)
+  {
+    if (!setTimeslot(t)) return(false);
+
+    for (uint8_t i = 0; i < sizeof(testPattern) / sizeof(testPattern[0]); i++)
+    {
+      packet_t reply;
+
+      if (!transact(testPattern[i], reply, true) || reply != (testPattern[i] & mask))
+        return(false);
+    }
+  }
+
+  return(true);
+}
+
+uint16_t MD_OnePin::negotiate(uint16_t tMin)
+{
+  uint16_t t = OPT;
+  uint16_t tGood = OPT;
+
+  // Step down by 1/8 of the current T each time until a test fails.
+  // Reset signals at each step are always recognized by SEC as they are
+  // much longer than a Read signal at the previous T.
+  while (t >= tMin && t > 1 && testTimeslot(t))
+  {
+    tGood = t;
+    t -= (t >= 8 ? t / 8 : 1);
+  }
+
+  OPPRINT("\nNegotiated: ", tGood);
+  setTimeslot(tGood);
+
+  return(tGood);
+}
+
+bool MD_OnePin::setOverdrive(bool on)
+{
+  if (on == _overdrive) return(true);
+
+  if (on)
+  {
+    uint16_t tPrev = _tm.t;
+
+    if (testTimeslot(OPT_OD))
+      _overdrive = true;
+    else
+      setTimeslot(tPrev);   // SEC cannot do it, so go back
+  }
+  else
+    setTimeslot(OPT);
+
+  OPPRINT("\nOverdrive: ", _overdrive);
+
+  return(_overdrive == on);
+}
+
+bool MD_OnePin::odFallback(void)
+{
+  OPPRINT("\nOverdrive fallback", "");
+  return(setTimeslot(OPT));   // also clears _overdrive
+}
@@ -53,18 +53,422 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
 \page pageRevisionHistory Revision History
+Oct 2026 ver 1.1.0
+- Added optional direct port register I/O backend (OP_FAST_IO)
+- Added MD_OnePinT compile time pin/timing class template
+- Added non-blocking timer driven transactions (startWrite(), startRead())
+- Added MD_OnePinGroup to run links on the same I/O port in lockstep
+- Added writeBuffer() and readBuffer() burst transfers
+- Added run time timeslot (T) changes and negotiation with SEC
+- Added MD_OnePin_SecTimer.h hardware timer signal timing for SEC
+- Added MD_OnePin_Sec packaged ISR driven SEC implementation
+- Added MD_OnePin_Sec lock-free receive and reply packet queues
+- Added MD_OnePinBench link benchmark
+- Added optional link statistics counters (OP_STATS, getStats())
+- Added deadline link timing using processor cycle counters
+- Added overdrive mode (setOverdrive())
+- Added optional 2 bit per signal write encoding (setEncoding())
+- Added optional packet CRC-8 with ACK/NAK and immediate retry (setCrc())
+- Added transact() write-read transactions with SEC busy signaling
+- Added SEC attention signal (setAttentionMode(), hasAttention())
+- Added length-prefixed frames (writeFrame(), readFrame())
+- Added MD_OnePin_SecTiny.h minimal footprint SEC for ATtiny processors
+- Added compile time and saved I/O calibration for a faster begin()
+- Added interrupt masking of the time critical part of each signal (OP_IRQ_MASK)
+- Added MD_OnePinRmt hardware waveform link using the ESP32 RMT peripheral
+- Added MD_OnePinService ESP32 link service task (submitWrite(), submitRead())
+- Added optional signal trace ring for PRI and SEC (OP_TRACE, OPS_TRACE)
+- Added host link simulator in extras/sim
+- Added readStream() and SEC reply pre-fetch for streaming packets
+- Added MD_OnePinReg register access and SEC register tables (opsSetRegisters())
+- Added MD_OnePinHealth link health monitor with automatic T fallback and recovery
+- Added opstSleep() low power sleep between signals to MD_OnePin_SecTiny.h
+- Added MD_OnePinGroup::broadcastWrite() to send one packet to all the links
+
 Sep 2021 ver 1.0.0
 - Initial release
 */
 
 #include <Arduino.h>
 #include <MD_OnePin_Protocol.h>
+#include <MD_OnePin_Crc.h>
+#include <MD_OnePin_Irq.h>
+#include <MD_OnePin_Trace.h>
 
 /**
  * \file
  * \brief Main header file and class definition for the MD_OnePin library.
  */
 
+/**
+\def OP_FAST_IO
+Set to 1 to replace the pinMode(), digitalWrite() and digitalRead() calls
+in the time critical sections with direct port register operations. The
+port registers and bit mask for the comms pin are worked out once, when
+the object is created.
+
+Supported for AVR, SAMD, ESP32 and RP2040 architectures. Other
+architectures silently revert to the standard Arduino I/O functions.
+
+This needs to be set in this header file as it changes the definition of
+the class for all compilation units.
+*/
+#ifndef OP_FAST_IO
+#define OP_FAST_IO 0
+#endif
+
+#if OP_FAST_IO
+#if defined(ARDUINO_ARCH_AVR)
+typedef uint8_t opIoReg_t;      ///< Native width of an I/O port register
+#elif defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_ESP32)
+typedef uint32_t opIoReg_t;     ///< Native width of an I/O port register
+#elif defined(ARDUINO_ARCH_RP2040)
+#include <hardware/structs/sio.h>
+typedef uint32_t opIoReg_t;     ///< Native width of an I/O port register
+#else
+#undef OP_FAST_IO
+#define OP_FAST_IO 0
+#endif
+#endif
+
+#if OP_FAST_IO
+/**
+ * Port registers and bit mask used for fast I/O on one pin.
+ */
+typedef struct
+{
+  volatile opIoReg_t *out; ///< output data register
+  volatile opIoReg_t *dir; ///< data direction register
+  volatile opIoReg_t *in;  ///< input data register
+  opIoReg_t mask;          ///< bit mask for the pin in the port registers
+} opIo_t;
+
+/**
+ * Work out the fast I/O registers and bit mask for a pin.
+ *
+ * \param io  the register block to initialize.
+ * \param pin the Arduino pin number.
+ */
+inline void opIoInit(opIo_t &io, uint8_t pin)
+{
+#if defined(ARDUINO_ARCH_RP2040)
+  io.out = &sio_hw->gpio_out;
+  io.dir = &sio_hw->gpio_oe;
+  io.in = &sio_hw->gpio_in;
+  io.mask = 1ul << pin;
+#else
+  io.out = portOutputRegister(digitalPinToPort(pin));
+  io.dir = portModeRegister(digitalPinToPort(pin));
+  io.in = portInputRegister(digitalPinToPort(pin));
+  io.mask = digitalPinToBitMask(pin);
+#endif
+}
+
+/**
+ * Set the masked bits in a fast I/O port register.
+ *
+ * \param reg  the port register (opIo_t out or dir).
+ * \param mask the bits to set.
+ */
+inline __attribute__((always_inline)) void opIoSet(volatile opIoReg_t *reg, opIoReg_t mask)
+{
+#if defined(ARDUINO_ARCH_AVR)
+  // AVR has no set/clear registers, so protect read-modify-write from ISRs
+  uint8_t s = SREG; cli(); *reg |= mask; SREG = s;
+#elif defined(ARDUINO_ARCH_SAMD)
+  reg[2] = mask;  // PORT registers are laid out as xxx, xxxCLR, xxxSET
+#else
+  reg[1] = mask;  // ESP32 GPIO and RP2040 SIO are laid out as xxx, xxx_SET, xxx_CLR
+#endif
+}
+
+/**
+ * Clear the masked bits in a fast I/O port register.
+ *
+ * \param reg  the port register (opIo_t out or dir).
+ * \param mask the bits to clear.
+ */
+inline __attribute__((always_inline)) void opIoClr(volatile opIoReg_t *reg, opIoReg_t mask)
+{
+#if defined(ARDUINO_ARCH_AVR)
+  uint8_t s = SREG; cli(); *reg &= ~mask; SREG = s;
+#elif defined(ARDUINO_ARCH_SAMD)
+  reg[1] = mask;
+#else
+  reg[2] = mask;
+#endif
+}
+#endif
+
+/**
+\def OP_DEADLINE_TIMING
+Set to 1 by the library when the processor has a free running cycle 
+counter that can be used for the link timing.
+
+With deadline timing each wait in a transaction counts down to an absolute 
+deadline measured from the start of the transaction, rather than delaying 
+for a time less the measured I/O overhead. The I/O overhead and any loop 
+overhead then no longer accumulate across the bits of a packet. If a signal
+starts late (eg, held up by an interrupt) the deadlines move with it, so 
+that a LOW signal is never shortened.
+
+Supported using the DWT CYCCNT register on Cortex-M3/M4/M7, the CPU cycle 
+count on ESP32 and the 1&micro;s system timer on RP2040. Other architectures 
+(eg, AVR, Cortex-M0+) use delayMicroseconds() compensated for the I/O 
+overhead, clamped so that the delay does not underflow.
+*/
+#if defined(ARDUINO_ARCH_ESP32)
+#define OP_DEADLINE_TIMING 1
+#define OP_TICKS_PER_US (F_CPU / 1000000UL)   ///< timing ticks per microsecond
+#elif (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)) && defined(DWT)
+#define OP_DEADLINE_TIMING 1
+#define OP_TICKS_PER_US (F_CPU / 1000000UL)   ///< timing ticks per microsecond
+#elif defined(ARDUINO_ARCH_RP2040)
+#include <hardware/timer.h>
+#define OP_DEADLINE_TIMING 1
+#define OP_TICKS_PER_US 1                     ///< timing ticks per microsecond
+#else
+#define OP_DEADLINE_TIMING 0
+#endif
+
+typedef uint32_t opTick_t;    ///< deadline timing tick count
+
+/**
+ * Initialize the deadline timing clock.
+ * 
+ * Enables the cycle counter if this needs to be done in software.
+ */
+inline void opClockBegin(void)
+{
+#if OP_DEADLINE_TIMING && !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_RP2040)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * Get the current deadline timing clock count.
+ *
+ * \return the current tick count, 0 if deadline timing is not supported.
+ */
+inline __attribute__((always_inline)) opTick_t opClockNow(void)
+{
+#if !OP_DEADLINE_TIMING
+  return(0);
+#elif defined(ARDUINO_ARCH_ESP32)
+  return(ESP.getCycleCount());
+#elif defined(ARDUINO_ARCH_RP2040)
+  return(time_us_32());
+#else
+  return(DWT->CYCCNT);
+#endif
+}
+
+/**
+ * Start the deadline timing for a transaction.
+ *
+ * \param deadline the transaction deadline, set to now.
+ */
+inline __attribute__((always_inline)) void opTimeStart(opTick_t &deadline)
+{
+#if OP_DEADLINE_TIMING
+  deadline = opClockNow();
+#else
+  (void)deadline;
+#endif
+}
+
+/**
+ * Move the deadline to now if it has already passed.
+ * 
+ * Called at the start of each LOW signal so that a late start does not
+ * shorten the signal.
+ *
+ * \param deadline the transaction deadline.
+ */
+inline __attribute__((always_inline)) void opTimeCatchUp(opTick_t &deadline)
+{
+#if OP_DEADLINE_TIMING
+  opTick_t now = opClockNow();
+
+  if ((int32_t)(now - deadline) > 0) deadline = now;
+#else
+  (void)deadline;
+#endif
+}
+
+/**
+ * Wait for the next deadline.
+ *
+ * With deadline timing the deadline is moved on by us and this waits until 
+ * it is reached. Otherwise this delays for us less the overhead comp, or 
+ * not at all if the overhead is greater.
+ *
+ * \param deadline the transaction deadline.
+ * \param us       the time from the last deadline in microseconds.
+ * \param comp     the I/O overhead since the last deadline in microseconds.
+ */
+inline __attribute__((always_inline)) void opTimeWait(opTick_t &deadline, uint16_t us, uint16_t comp)
+{
+#if OP_DEADLINE_TIMING
+  (void)comp;
+  deadline += (opTick_t)us * OP_TICKS_PER_US;
+  while ((int32_t)(opClockNow() - deadline) < 0)
+    ;   // wait
+#else
+  (void)deadline;
+  if (us > comp) delayMicroseconds(us - comp);
+#endif
+}
+
+/**
+\def OP_IRQ_MASK
+Sets when interrupts are masked during PRI link signaling.
+
+An interrupt serviced while the link is LOW stretches the signal (eg, a
+Write 1 becomes a Write 0) and one serviced between releasing the link and
+sampling it can delay the sample past the point where SEC is driving the
+link. The only other remedy is a larger T.
+
+- 0 never masks interrupts.
+- 1 (default) masks interrupts only in the time critical part of each
+  signal, from the start of the LOW signal up to the sample where there is
+  one, and enables them again for the HIGH remainder of the timeslot.
+  Interrupts held off are serviced in the pause, so other ISRs wait at
+  most one signal (the longest is the Sync or Reset and presence sample)
+  rather than a whole packet.
+
+The interrupt state is saved and restored rather than just enabled, so a
+transaction started with interrupts off leaves them off. Used by
+MD_OnePin, MD_OnePinT and MD_OnePinGroup.
+*/
+#ifndef OP_IRQ_MASK
+#define OP_IRQ_MASK 1
+#endif
+
+/**
+ * Mask interrupts for a time critical part of a signal.
+ *
+ * Does nothing if OP_IRQ_MASK is 0.
+ *
+ * \return the interrupt state to pass to opIrqRestore().
+ */
+inline __attribute__((always_inline)) opIrqState_t opIrqSave(void)
+{
+#if !OP_IRQ_MASK
+  return(0);
+#else
+  return(opIrqLock());
+#endif
+}
+
+/**
+ * Restore the interrupt state saved by opIrqSave().
+ *
+ * \param s the interrupt state returned by opIrqSave().
+ */
+inline __attribute__((always_inline)) void opIrqRestore(opIrqState_t s)
+{
+#if !OP_IRQ_MASK
+  (void)s;
+#else
+  opIrqUnlock(s);
+#endif
+}
+
+/**
+\def OP_STATS
+Set to 1 to enable the link statistics counters, retrieved with 
+MD_OnePin::getStats(). The counters add a few instructions to each bit 
+and a micros() call at the start and end of each blocking transaction, 
+so they are light enough to leave on in production code.
+
+This needs to be set in this header file as it changes the definition of
+the class for all compilation units.
+*/
+#ifndef OP_STATS
+#define OP_STATS 0
+#endif
+
+#if OP_STATS
+/**
+ * Link statistics counters.
+ *
+ * \sa MD_OnePin::getStats()
+ */
+typedef struct
+{
+  uint32_t transactions;  ///< transactions completed, blocking and non-blocking
+  uint32_t bitsSent;      ///< data bits sent to SEC
+  uint32_t bitsRecv;      ///< data bits received from SEC
+  uint32_t presenceFail;  ///< Comms Reset signals with no SEC presence response
+  uint32_t crcErrors;     ///< packets with a CRC error, including those retried successfully
+  uint32_t usBlocked;     ///< total microseconds spent in blocking transactions
+  uint16_t maxOverrun;    ///< worst microseconds a blocking transaction took over its nominal signal time
+} opStats_t;
+#endif
+
+/**
+\def OP_TRACE
+Set to 1 to record each signal in a trace ring, read with 
+MD_OnePin::readTrace(). The signal type and the measured LOW and HIGH times
+are recorded in the blocking transactions, timed with the cycle counter 
+where the processor has one (OP_DEADLINE_TIMING) and micros() otherwise. 
+The micros() calls add a few microseconds to each signal on AVR.
+
+This needs to be set in this header file as it changes the definition of
+the class for all compilation units.
+*/
+#ifndef OP_TRACE
+#define OP_TRACE 0
+#endif
+
+/**
+\def OP_TRACE_SIZE
+The number of signals kept in the trace ring when OP_TRACE is enabled.
+This must be a power of 2 and no more than 128.
+*/
+#ifndef OP_TRACE_SIZE
+#define OP_TRACE_SIZE 32
+#endif
+
+/**
+ * Link timing parameters in microseconds, worked out for one timeslot T.
+ *
+ * \sa \ref pageLinkSignals, MD_OnePin_Protocol.h
+ */
+typedef struct
+{
+  uint16_t t;             ///< the timeslot T
+  uint16_t rstSignal;     ///< OPT_RST_SIGNAL for T
+  uint16_t rstPrsSample;  ///< OPT_RST_PRS_SAMPLE for T
+  uint16_t rstEnd;        ///< OPT_RST_END for T
+  uint16_t wr1Signal;     ///< OPT_WR1_SIGNAL for T
+  uint16_t wr1Pause;      ///< OPT_WR1_PAUSE for T
+  uint16_t wr0Signal;     ///< OPT_WR0_SIGNAL for T
+  uint16_t wr0Pause;      ///< OPT_WR0_PAUSE for T
+  uint16_t rdInit;        ///< OPT_RD_INIT for T
+  uint16_t rdSample;      ///< OPT_RD_SAMPLE for T
+  uint16_t rdPause;       ///< OPT_RD_PAUSE for T
+  uint16_t symSignal[4];  ///< OPT_SYMn_SIGNAL for T, indexed by symbol value
+  uint16_t symPause;      ///< OPT_SYM_PAUSE for T
+  uint16_t frmSignal;     ///< OPT_FRM_SIGNAL for T
+} opTiming_t;
+
+/**
+ * I/O overhead calibration for a link, measured in MD_OnePin::begin().
+ *
+ * The values can be saved (eg, in EEPROM) and passed to begin() on the 
+ * next start to skip the measurement.
+ *
+ * \sa MD_OnePin::begin(), MD_OnePin::getCalibration()
+ */
+typedef struct
+{
+  uint16_t switchTime;  ///< average microseconds to switch the pin between INPUT and OUTPUT
+  uint16_t writeTime;   ///< average microseconds to write the pin HIGH or LOW
+} opCalib_t;
+
 /**
  * Core object for the MD_OnePin library
  */
@@ -74,6 +478,40 @@ public:
 
   typedef opPriPacket_t packet_t;    ///< The Primary side comms packet. Defined as max size to fit all supported types.
 
+  /**
+   * Encoding used for data written to SEC.
+   *
+   * \sa setEncoding(), \ref pageLinkSignals
+   */
+  typedef enum
+  {
+    ENC_1BIT,   ///< one bit per Write 0/Write 1 signal (default)
+    ENC_2BIT,   ///< two bits per write symbol signal
+  } encoding_t;
+
+  /**
+   * Non-blocking transaction completion callback function.
+   *
+   * The callback is invoked from runAsync() when a transaction started
+   * using startWrite() or startRead() has completed. As runAsync() is
+   * normally run from a timer ISR, the callback needs to be short.
+   *
+   * \param op   the object that has completed the transaction.
+   * \param data the data received for a read, the data sent for a write.
+   */
+  typedef void (*cbComplete_t)(MD_OnePin *op, packet_t data);
+
+  /**
+   * SEC attention callback function.
+   *
+   * The callback is invoked from attentionISR() when SEC sends an Attention
+   * signal. As this runs in an ISR, the callback needs to be short and 
+   * should not start a transaction.
+   *
+   * \param op the object for the link that SEC is asking for attention on.
+   */
+  typedef void (*cbAttention_t)(MD_OnePin *op);
+
   //--------------------------------------------------------------
   /** \name Class constructor and destructor.
    * @{
@@ -91,8 +529,22 @@ public:
    * \param bppSec the number of bits per packet (bpp) received from SEC
    */
     MD_OnePin(uint8_t pin, uint8_t bppPri = BPP_PRI, uint8_t bppSec = BPP_SEC) :
-        _pin(pin), _presence(false), _bppPri(bppPri), _bppSec(bppSec)
-        {};
+        _pin(pin), _presence(false), _overdrive(false), _encoding(ENC_1BIT), 
+        _crc(false), _crcOk(true), _bppPri(bppPri), _bppSec(bppSec),
+        _attnMode(false), _attn(false), _linkBusy(0), _cbAttention(nullptr),
+        _asyncState(0), _cbComplete(nullptr)
+        {
+          setTiming(OPT);
+#if OP_FAST_IO
+          opIoInit(_io, _pin);
+#endif
+#if OP_STATS
+          clearStats();
+#endif
+#if OP_TRACE
+          clearTrace();
+#endif
+        };
   
    /**
     * Class Destructor.
@@ -112,9 +564,37 @@ public:
    *
    * Initialize the object data. This needs to be called during setup()
    * to set items that cannot be done during object creation.
+   *
+   * The time taken by the pin I/O operations is measured so that it can be
+   * allowed for in the link timing, unless the values are fixed at compile 
+   * time with OP_SWITCH_TIME and OP_WRITE_TIME in MD_OnePin.cpp.
+   *
+   * \sa getCalibration()
    */
     void begin(void);
 
+  /**
+   * Initialize the object with a known I/O calibration.
+   *
+   * As begin(void) but uses the calibration values supplied instead of 
+   * measuring them, giving a faster and repeatable start. The values will
+   * normally have been saved from getCalibration() on an earlier start.
+   *
+   * \sa getCalibration()
+   *
+   * \param cal the I/O calibration to use.
+   */
+    void begin(const opCalib_t &cal);
+
+  /**
+   * Get the I/O calibration.
+   *
+   * \sa begin()
+   *
+   * \return the I/O calibration in use, measured or set in begin().
+   */
+    inline opCalib_t getCalibration(void) { opCalib_t cal = { _switchTime, _writeTime }; return(cal); }
+
   /**
    * Write a PRI data packet.
    *
@@ -144,6 +624,112 @@ public:
    */
     packet_t read(bool noReset = false);
 
+  /**
+   * Write a command packet and read the reply in one transaction.
+   *
+   * The PRI initiates a Reset/Presence signal with SEC, sends the command
+   * packet and then waits in turnaround slots until SEC signals that the 
+   * reply is ready, up to OP_BUSY_SLOTS slots. The reply packet is then read
+   * straight away. This saves the second Reset/Presence of a write() followed 
+   * by a read(). The SEC must support write-read transactions.
+   *
+   * \sa write(), read(), \ref pageImplementation
+   *
+   * \param cmd     the command packet to send to the SEC.
+   * \param reply   the reply received from the SEC. Set to 0xffffffff if there is no reply.
+   * \param noReset set true to omit the Comms Reset signal. Defaults to false (ie, reset).
+   * \return true if the reply was received correctly.
+   */
+    bool transact(packet_t cmd, packet_t &reply, bool noReset = false);
+
+  /**
+   * Write a buffer of data to SEC in one transaction.
+   *
+   * The PRI initiates a Reset/Presence signal with SEC and then writes 
+   * (Write 0/1 Signals) all the bits in the buffer as one continuous stream, 
+   * starting with the LSB of the first byte. SEC receives this as consecutive
+   * packets of the configured size. The last packet is padded with 0 bits 
+   * if the buffer does not fill it.
+   *
+   * \sa write(), \ref pageImplementation
+   *
+   * \param buf the data to sent to the SEC.
+   * \param len the number of bytes in the buffer.
+   * \return true if the SEC device was present.
+   */
+    bool writeBuffer(const uint8_t *buf, size_t len);
+
+  /**
+   * Read a buffer of data from SEC in one transaction.
+   *
+   * The PRI initiates a Reset/Presence signal with SEC and then requests
+   * (Read Signal) enough bits to fill the buffer as one continuous stream, 
+   * starting with the LSB of the first byte. SEC sends this as consecutive
+   * packets of the configured size.
+   *
+   * \sa read(), \ref pageImplementation
+   *
+   * \param buf the buffer for the data received from the SEC. Set to all 0xff if SEC is not present.
+   * \param len the number of bytes to read into the buffer.
+   * \return true if the SEC device was present.
+   */
+    bool readBuffer(uint8_t *buf, size_t len);
+
+  /**
+   * Read a stream of packets from SEC in one transaction.
+   *
+   * The PRI initiates a Reset/Presence signal with SEC and then reads count
+   * packets back to back, with no Reset/Presence between them. SEC sends 
+   * each packet as soon as the last one is complete, so a SEC that has its
+   * next packets ready (eg, opsQueueReply() in the packaged SEC) can stream 
+   * at the full bit rate of the link. With noReset set, a stream can be 
+   * continued in further calls from where the last one stopped.
+   *
+   * Each packet is checked separately if CRC is enabled.
+   *
+   * \sa read(), readBuffer(), \ref pageImplementation
+   *
+   * \param buf     the buffer for the packets received. Set to all 0xffffffff if SEC is not present.
+   * \param count   the number of packets to read.
+   * \param noReset set true to omit the Comms Reset signal and continue a stream. Defaults to false (ie, reset).
+   * \return true if the SEC device was present (and all the packets passed the CRC check).
+   */
+    bool readStream(packet_t *buf, uint16_t count, bool noReset = false);
+
+  /**
+   * Write a length-prefixed frame to SEC.
+   *
+   * The PRI initiates a Reset/Presence signal with SEC, then a Frame signal,
+   * followed by the length byte and the data bytes. This moves blocks of 
+   * data larger than a packet in one transaction, and SEC receives it as
+   * bytes rather than packets. With CRC enabled the frame is checked and 
+   * ACKed by SEC as a whole, but is not retried. The SEC must support frames.
+   *
+   * \sa readFrame(), \ref pageLinkSignals
+   *
+   * \param buf the data to send to the SEC.
+   * \param len the number of bytes in the buffer (up to 255).
+   * \return true if the frame was received by SEC.
+   */
+    bool writeFrame(const uint8_t *buf, uint8_t len);
+
+  /**
+   * Read a length-prefixed frame from SEC.
+   *
+   * The PRI initiates a Reset/Presence signal with SEC, then a Frame signal,
+   * and reads the length byte and the data bytes sent by SEC. If the frame
+   * is longer than the buffer only the first size bytes are kept, but the 
+   * whole frame is read. The SEC must support frames.
+   *
+   * \sa writeFrame(), \ref pageLinkSignals
+   *
+   * \param buf  the buffer for the data received from the SEC.
+   * \param size the size of the buffer in bytes.
+   * \param len  the length of the frame sent by SEC, 0 if there was no frame.
+   * \return true if the frame was received correctly.
+   */
+    bool readFrame(uint8_t *buf, uint8_t size, uint8_t &len);
+
   /**
    * Secondary device presence status.
    *
@@ -160,17 +746,432 @@ public:
    */
     inline bool isPresent(void) { return(_presence); }
 
+  /**
+   * Set the encoding for data written to SEC.
+   *
+   * With ENC_2BIT each write signal carries 2 bits using one of 4 signal 
+   * lengths, roughly halving the time to write a packet. The SEC must be 
+   * set up for the same encoding. Reads are not affected.
+   *
+   * \sa getEncoding(), \ref pageLinkSignals
+   *
+   * \param enc the encoding to use for writes.
+   */
+    inline void setEncoding(encoding_t enc) { _encoding = enc; }
+
+  /**
+   * Get the encoding for data written to SEC.
+   *
+   * \sa setEncoding()
+   *
+   * \return the current write encoding.
+   */
+    inline encoding_t getEncoding(void) { return(_encoding); }
+
+  /**
+   * Enable or disable packet CRC checking.
+   *
+   * When enabled, an 8 bit CRC follows every packet. For a write, SEC 
+   * checks the CRC and signals ACK or NAK in a following read slot. For a 
+   * read, PRI checks the CRC and signals ACK or NAK with a following write 
+   * signal. A packet that is NAKed is immediately sent again, up to 
+   * OP_CRC_RETRIES times, without a new Comms Reset. The SEC must be set 
+   * up for CRC checking as well.
+   *
+   * write(), writeBuffer() and readBuffer() return false if a packet still
+   * fails its CRC check after retries, and isCrcOk() reports the status of
+   * the last transaction (including read()).
+   *
+   * Non-blocking transactions are not supported with CRC, so startWrite()
+   * and startRead() return false when it is enabled. MD_OnePinT and
+   * MD_OnePinGroup lockstep transactions do not use CRC.
+   *
+   * \sa isCrcOk(), \ref pageLinkSignals
+   *
+   * \param on true to enable CRC, false to disable.
+   */
+    inline void setCrc(bool on) { _crc = on; }
+
+  /**
+   * Check the CRC status of the last transaction.
+   *
+   * \sa setCrc()
+   *
+   * \return false if a packet in the last transaction failed the CRC check after all retries.
+   */
+    inline bool isCrcOk(void) { return(_crcOk); }
+
   /** @} */
 
+  //--------------------------------------------------------------
+  /** \name Methods for link timeslot management.
+   * @{
+   */
+  /**
+   * Change the link timeslot.
+   *
+   * PRI sends a Sync signal followed by a Reset signal using the new 
+   * timeslot T, which SEC uses to set its own timing. All further 
+   * communications will use the new T. 
+   *
+   * This starts a test frame, where SEC will respond to a read() with the 
+   * last packet written to it. The test frame ends with the next Reset.
+   *
+   * The SEC needs to support timeslot changes. Legacy SEC devices treat
+   * the Sync signal as a Reset and keep using the default timeslot OPT.
+   *
+   * T must be in the range OPT_MIN to OPT_MAX. Above OPT_MAX the Reset 
+   * signal is long enough for SEC to see it as a Sync. A T out of range is 
+   * refused without any signals being sent. If SEC is not present, or does
+   * not accept the new T, the link keeps the previous T.
+   *
+   * \sa negotiate(), \ref pageLinkSignals
+   *
+   * \param t the new timeslot T in microseconds.
+   * \return true if the SEC device was present at the new T, false if it was not or T is out of range.
+   */
+    bool setTimeslot(uint16_t t);
+
+  /**
+   * Get the current link timeslot.
+   *
+   * \sa setTimeslot(), negotiate()
+   *
+   * \return the current timeslot T in microseconds.
+   */
+    inline uint16_t getTimeslot(void) { return(_tm.t); }
+
+  /**
+   * Negotiate the smallest reliable link timeslot.
+   *
+   * Starting with the default timeslot OPT, PRI progressively reduces T and
+   * for each new T uses test frames to write known data patterns to SEC and 
+   * read them back. The smallest T for which all the data patterns are 
+   * correctly returned is set as the link timeslot.
+   *
+   * Note that legacy SEC devices, which do not support test frames, will 
+   * receive the test patterns as normal data. Negotiation will fail at the
+   * first step and the default timeslot OPT is retained.
+   *
+   * \sa setTimeslot(), \ref pageLinkSignals
+   *
+   * \param tMin the smallest T to try, in microseconds. Defaults to OPT_MIN.
+   * \return the timeslot T selected, in microseconds.
+   */
+    uint16_t negotiate(uint16_t tMin = OPT_MIN);
+
+  /**
+   * Switch overdrive mode on or off.
+   *
+   * Overdrive sets the link timeslot to the high speed OPT_OD for bulk 
+   * transfers. Switching on sets the overdrive T and checks it with test 
+   * frames. If the SEC does not support overdrive, or the test fails, the 
+   * previous T is restored.
+   *
+   * While in overdrive, a transaction that gets no presence response drops
+   * back to the default timeslot OPT and is retried once. Switching off 
+   * also returns to OPT.
+   *
+   * \sa isOverdrive(), setTimeslot(), \ref pageLinkSignals
+   *
+   * \param on true to switch overdrive on, false to switch it off.
+   * \return true if the link is running at the requested speed.
+   */
+    bool setOverdrive(bool on);
+
+  /**
+   * Check if the link is in overdrive mode.
+   *
+   * \sa setOverdrive()
+   *
+   * \return true if the link is running at the overdrive timeslot.
+   */
+    inline bool isOverdrive(void) { return(_overdrive); }
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for non-blocking transactions.
+   * @{
+   */
+  /**
+   * Start a non-blocking PRI data packet write.
+   *
+   * Set up the same sequence of signals as write() to be clocked out by 
+   * subsequent calls to runAsync(). The method returns immediately and 
+   * completion is notified through the callback set by setCallback().
+   *
+   * \sa write(), runAsync(), \ref pageImplementation
+   *
+   * \param data    the data to sent to the SEC. Only the configured number of bits will be transmitted.
+   * \param noReset set true to omit the Comms Reset signal before sending data. Defaults to false (ie, reset).
+   * \return true if the transaction was started, false if a transaction is already in progress or CRC is enabled.
+   */
+    bool startWrite(packet_t data, bool noReset = false);
+
+  /**
+   * Start a non-blocking SEC data packet request.
+   *
+   * Set up the same sequence of signals as read() to be clocked out by 
+   * subsequent calls to runAsync(). The method returns immediately and 
+   * the received data is passed to the callback set by setCallback().
+   *
+   * \sa read(), runAsync(), \ref pageImplementation
+   *
+   * \param noReset set true to omit the Comms Reset signal before reading data. Defaults to false (ie, reset).
+   * \return true if the transaction was started, false if a transaction is already in progress or CRC is enabled.
+   */
+    bool startRead(bool noReset = false);
+
+  /**
+   * Check if a non-blocking transaction is in progress.
+   *
+   * \sa startWrite(), startRead()
+   *
+   * \return true if a transaction started by startWrite() or startRead() has not completed.
+   */
+    inline bool isBusy(void) { return(_asyncState != 0); }
+
+  /**
+   * Set the non-blocking transaction completion callback.
+   *
+   * \sa cbComplete_t
+   *
+   * \param cb the callback function, nullptr to disable.
+   */
+    inline void setCallback(cbComplete_t cb) { _cbComplete = cb; }
+
+  /**
+   * Run the next step of a non-blocking transaction.
+   *
+   * Each call performs the next signal edge of the transaction in progress
+   * and returns the time until the following edge is due. This is designed 
+   * to be called from a hardware timer compare ISR, which reloads the timer 
+   * with the returned value. The first call should be made as soon as the 
+   * transaction is started.
+   *
+   * If the library has been compiled with OP_ASYNC_TIMER1 set to 1, the 
+   * library provides the AVR Timer1 ISR that calls this method and this 
+   * does not need to be called by the application.
+   *
+   * \sa startWrite(), startRead(), \ref pageImplementation
+   *
+   * \return microseconds to the next call, 0 when the transaction has completed.
+   */
+    uint16_t runAsync(void);
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for SEC attention requests.
+   * @{
+   */
+  /**
+   * Switch attention mode on or off.
+   *
+   * In attention mode PRI leaves the link as an input (pulled HIGH) between
+   * transactions, rather than driving it HIGH, so that SEC can send an 
+   * Attention signal to ask for communications. Attention signals are 
+   * detected by attentionISR() or by hasAttention() checking the link.
+   *
+   * Attention mode must be on before SEC sends Attention signals, as 
+   * otherwise SEC and PRI would both be driving the link. MD_OnePinGroup 
+   * lockstep transactions are not used for links in attention mode.
+   *
+   * \sa hasAttention(), attentionISR(), \ref pageLinkSignals
+   *
+   * \param on true to switch attention mode on, false to switch it off.
+   */
+    void setAttentionMode(bool on);
+
+  /**
+   * Check if attention mode is on.
+   *
+   * \sa setAttentionMode()
+   *
+   * \return true if the link is in attention mode.
+   */
+    inline bool isAttentionMode(void) { return(_attnMode); }
+
+  /**
+   * Check if SEC has asked for attention.
+   *
+   * Returns true if an Attention signal has been detected since the last 
+   * call. Attention signals are detected by attentionISR(), at the start of
+   * each transaction, and by this method if the link is LOW when it is 
+   * called. Without attentionISR() a short Attention signal between 
+   * checks can be missed, so polling this should only be used as a slow 
+   * fallback.
+   *
+   * \sa attentionISR(), setAttentionMode()
+   *
+   * \return true if SEC has asked for attention, false otherwise.
+   */
+    bool hasAttention(void);
+
+  /**
+   * Attention signal interrupt handler.
+   *
+   * Call this from the application ISR for a falling edge on the comms pin,
+   * attached using attachInterrupt(). Falling edges during PRI transactions
+   * are ignored, so only Attention signals from SEC are counted. 
+   *
+   * \sa hasAttention(), setAttentionCallback()
+   */
+    void attentionISR(void);
+
+  /**
+   * Set the SEC attention callback.
+   *
+   * \sa cbAttention_t, attentionISR()
+   *
+   * \param cb the callback function, nullptr to disable.
+   */
+    inline void setAttentionCallback(cbAttention_t cb) { _cbAttention = cb; }
+
+  /** @} */
+
+#if OP_STATS
+  //--------------------------------------------------------------
+  /** \name Methods for link statistics.
+   * Only available when the library is compiled with OP_STATS set to 1.
+   * @{
+   */
+  /**
+   * Get the link statistics.
+   *
+   * The counters accumulate from when the object is created or the 
+   * last call to clearStats().
+   *
+   * \sa opStats_t, clearStats()
+   *
+   * \return reference to the statistics counters.
+   */
+    inline const opStats_t &getStats(void) { return(_stats); }
+
+  /**
+   * Reset all the link statistics counters to 0.
+   *
+   * \sa getStats()
+   */
+    inline void clearStats(void) { memset(&_stats, 0, sizeof(_stats)); }
+
+  /** @} */
+#endif
+
+#if OP_TRACE
+  //--------------------------------------------------------------
+  /** \name Methods for the signal trace.
+   * Only available when the library is compiled with OP_TRACE set to 1.
+   * @{
+   */
+  /**
+   * Get the number of trace records held.
+   *
+   * \sa readTrace()
+   *
+   * \return the number of records that can be read, up to OP_TRACE_SIZE.
+   */
+    inline uint8_t traceAvailable(void) { return(_traceCount); }
+
+  /**
+   * Read the oldest trace record.
+   *
+   * Records are read oldest first and removed from the trace. The trace 
+   * is only written by the blocking transactions, so this should not be 
+   * called from an ISR or another task while one is running.
+   *
+   * \sa opTrace_t, MD_OnePin_Trace.h
+   *
+   * \param rec the record read.
+   * \return true if a record was read, false if the trace is empty.
+   */
+    bool readTrace(opTrace_t &rec);
+
+  /**
+   * Remove all the trace records.
+   *
+   * \sa readTrace()
+   */
+    inline void clearTrace(void) { _traceHead = _traceCount = 0; _traceEdge = 0; }
+
+  /** @} */
+#endif
+
 private:
+  friend class MD_OnePinGroup;
+  friend class MD_OnePinBench;
+  friend class MD_OnePinReg;
+  friend class MD_OnePinHealth;
+
   uint8_t _pin;      ///< comms pin number
   bool    _presence; ///< result of the last presence check (true if present)
+  bool    _overdrive; ///< true if running at the overdrive timeslot
+  encoding_t _encoding; ///< encoding for data written to SEC
+  bool    _crc;      ///< true if packets are sent with a CRC
+  bool    _crcOk;    ///< false if the last transaction had a CRC error after retries
   uint8_t _bppPri;   ///< number of bits per packet for primary send
   uint8_t _bppSec;   ///< number of bits per pack for primary receive (secondary send)
 
+  opTiming_t _tm;       ///< link timing for the current timeslot
+
   uint16_t _switchTime; ///< average microseconds for a SET_TO_* operation; calculate in begin()
   uint16_t _writeTime;  ///< average microseconds for a digitalWrite() operation; calculate in begin()
 
+#if OP_FAST_IO
+  opIo_t _io;           ///< cached fast I/O registers for _pin
+#endif
+
+  opTick_t _deadline;    ///< deadline for the current transaction wait
+
+  // SEC attention state
+  bool     _attnMode;        ///< true if the link is left as an input between transactions
+  volatile bool _attn;       ///< an Attention signal has been detected
+  volatile uint8_t _linkBusy; ///< nesting count of the transactions in progress
+  cbAttention_t _cbAttention; ///< SEC attention callback
+
+#if OP_STATS
+  opStats_t _stats;      ///< link statistics counters
+  uint32_t _statStart;   ///< micros() at the start of the current blocking transaction
+  uint32_t _statNominal; ///< nominal signal time of the current blocking transaction
+
+  void statEnd(void);   ///< Update the statistics at the end of a blocking transaction
+#endif
+
+#if OP_TRACE
+  opTrace_t _trace[OP_TRACE_SIZE]; ///< signal trace ring
+  uint8_t  _traceHead;   ///< next record written
+  uint8_t  _traceCount;  ///< number of records held
+  uint32_t _traceEdge;   ///< time of the last signal edge traced
+
+  void traceLow(uint8_t type);   ///< Trace the start of a LOW signal
+  void traceHigh(void);          ///< Trace the end of a LOW signal
+  void traceSample(bool high);   ///< Trace the link level sampled after the last signal
+#endif
+
+  opCalib_t calibrate(void); ///< Measure the I/O overhead for the comms pin
   bool resetComm(void); ///< Send a reset command and detect a presence response
                         ///< Returns false if there is no device present
+  void setTiming(uint16_t t); ///< Work out the link timing parameters for timeslot t
+  bool testTimeslot(uint16_t t); ///< Check test patterns are returned correctly at timeslot t
+  bool odFallback(void); ///< Drop out of overdrive after a failure; true if SEC is present at OPT
+  void sendBit(bool b); ///< Send one bit using a Write 0/1 signal
+  void sendSymbol(uint8_t s, uint8_t bits); ///< Send a 2 bit symbol carrying 1 or 2 data bits
+  void sendBits(packet_t data, uint8_t bits); ///< Send bits LSB first using the current encoding
+  bool writePacket(packet_t data);  ///< Send one packet, with CRC and retries if enabled; false if not ACKed
+  packet_t readPacket(bool &ok);    ///< Receive one packet, with CRC and retries if enabled; ok false on CRC error
+  bool recvBit(void);   ///< Receive one bit using a Read signal
+  uint8_t recvByte(void); ///< Receive 8 bits LSB first using Read signals
+  bool frameStart(void); ///< Reset and send the Frame signal; false if SEC is not present or does not support frames
+  void linkStart(void); ///< Take control of the link at the start of a transaction
+  void linkEnd(void);   ///< Release the link at the end of a transaction
+
+  // Non-blocking transaction state
+  volatile uint8_t _asyncState; ///< current step in the non-blocking transaction (0 if idle)
+  bool     _asyncRead;   ///< true if the non-blocking transaction is a read
+  uint8_t  _asyncBit;    ///< current bit number for the non-blocking transaction
+  packet_t _asyncData;   ///< data being sent or received by the non-blocking transaction
+  cbComplete_t _cbComplete;  ///< non-blocking transaction completion callback
+
+  bool startAsync(bool isRead, packet_t data, bool noReset); ///< common setup for startWrite() and startRead()
 };
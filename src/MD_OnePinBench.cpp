@@ -0,0 +1,83 @@
+#include <MD_OnePinBench.h>
+
+/**
+ * \file
+ * \brief Code file for MD_OnePinBench link benchmark class (PRI implementation).
+ */
+
+void MD_OnePinBench::addTop(uint16_t lat, uint8_t size)
+{
+  int8_t i = size - 1;
+
+  if (lat <= _top[i]) return;
+
+  // insertion sort into the descending list, dropping the smallest
+  for (; i > 0 && _top[i - 1] < lat; i--)
+    _top[i] = _top[i - 1];
+  _top[i] = lat;
+}
+
+void MD_OnePinBench::run(benchOp_t op, uint16_t count, result_t &res, bool noReset)
+{
+  uint16_t topSize = count / 100 + 1;    // nearest rank of the 99th percentile, from the top
+  uint32_t bits = 0;
+  uint32_t timeStart;
+  MD_OnePin::packet_t data = 0;
+
+  if (topSize > OPB_TOP_SIZE) topSize = OPB_TOP_SIZE;
+  memset(_top, 0, sizeof(_top));
+
+  res.t = _link.getTimeslot();
+  res.bppPri = _link._bppPri;
+  res.bppSec = _link._bppSec;
+  res.count = count;
+  res.fail = 0;
+  res.latMin = 0xffff;
+  res.latMax = 0;
+
+  timeStart = micros();
+  for (uint16_t i = 0; i < count; i++)
+  {
+    bool doWrite = (op == BENCH_WRITE) || (op == BENCH_WRITE_READ && (i & 1) == 0);
+    bool skipReset = noReset && i != 0;
+    uint32_t timeOp = micros();
+    uint16_t lat;
+
+    if (doWrite) 
+      _link.write(data++, skipReset);
+    else
+      _link.read(skipReset);
+    lat = micros() - timeOp;
+
+    if (!_link.isPresent()) res.fail++;
+    else bits += (doWrite ? res.bppPri : res.bppSec);
+
+    if (lat < res.latMin) res.latMin = lat;
+    if (lat > res.latMax) res.latMax = lat;
+    addTop(lat, topSize);
+  }
+  res.usTotal = micros() - timeStart;
+
+  if (count == 0) res.latMin = 0;
+  res.latAvg = (count == 0) ? 0 : res.usTotal / count;
+  res.latP99 = _top[topSize - 1];
+  res.bitsPerSec = (res.usTotal == 0) ? 0 : (uint32_t)(((uint64_t)bits * 1000000UL) / res.usTotal);
+}
+
+void MD_OnePinBench::sweep(benchOp_t op, uint16_t count, const uint16_t t[], uint8_t tCount, result_t res[])
+{
+  uint16_t tOrig = _link.getTimeslot();
+
+  for (uint8_t i = 0; i < tCount; i++)
+  {
+    if (_link.setTimeslot(t[i]))   // refused if out of range or SEC cannot do it
+      run(op, count, res[i]);
+    else
+    {
+      memset(&res[i], 0, sizeof(result_t));
+      res[i].t = t[i];
+    }
+  }
+
+  _link.setTimeslot(tOrig);
+}
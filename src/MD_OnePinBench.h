@@ -0,0 +1,148 @@
+#pragma once
+
+#include <MD_OnePin.h>
+
+/**
+ * \file
+ * \brief Header file and class definition for the MD_OnePinBench link benchmark object.
+ */
+
+/**
+\def OPB_TOP_SIZE
+The number of the slowest transactions kept to work out the 99th percentile
+latency. The 99th percentile is the (count / 100 + 1)th slowest transaction,
+so the result is exact for runs of less than 100 * OPB_TOP_SIZE transactions.
+*/
+#ifndef OPB_TOP_SIZE
+#define OPB_TOP_SIZE 8
+#endif
+
+/**
+ * Link benchmark object for the MD_OnePin library.
+ *
+ * The benchmark runs a number of back to back transactions on a link and
+ * measures the sustained throughput, the latency of each transaction and
+ * the number of presence failures. A sweep runs the same benchmark for a
+ * list of timeslot values, which needs a SEC that supports run time
+ * timeslot changes.
+ *
+ * The packet sizes are fixed for each link by the SEC, so results for different
+ * packet sizes are obtained by benchmarking links (and SEC) with those sizes.
+ *
+ * All times are measured with micros(), so have the resolution of micros()
+ * for the processor (4&micro;s for 16MHz AVR processors).
+ *
+ * \sa \ref pageImplementation
+ */
+class MD_OnePinBench
+{
+public:
+  /**
+   * Benchmark transaction type.
+   */
+  typedef enum
+  {
+    BENCH_WRITE,       ///< PRI write() transactions
+    BENCH_READ,        ///< PRI read() transactions
+    BENCH_WRITE_READ,  ///< alternating write() and read() transactions
+  } benchOp_t;
+
+  /**
+   * Benchmark results.
+   */
+  typedef struct
+  {
+    uint16_t t;           ///< timeslot T in microseconds
+    uint8_t  bppPri;      ///< bits per packet PRI to SEC for the link
+    uint8_t  bppSec;      ///< bits per packet SEC to PRI for the link
+    uint16_t count;       ///< transactions run
+    uint16_t fail;        ///< transactions with no SEC presence
+    uint32_t usTotal;     ///< total time for all the transactions
+    uint32_t bitsPerSec;  ///< data bits successfully transferred per second
+    uint16_t latMin;      ///< minimum transaction time in microseconds
+    uint16_t latAvg;      ///< average transaction time in microseconds
+    uint16_t latMax;      ///< maximum transaction time in microseconds
+    uint16_t latP99;      ///< 99th percentile transaction time in microseconds
+  } result_t;
+
+  //--------------------------------------------------------------
+  /** \name Class constructor and destructor.
+   * @{
+   */
+  /**
+   * Class Constructor
+   *
+   * Instantiate a new instance of the class for a link. The link needs to
+   * be initialized with begin() before it is benchmarked.
+   *
+   * \param link the MD_OnePin link to benchmark.
+   */
+  MD_OnePinBench(MD_OnePin &link) : _link(link) {};
+
+  /**
+   * Class Destructor.
+   *
+   * Release any allocated memory and clean up anything else.
+   */
+  ~MD_OnePinBench() {};
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for benchmarking.
+   * @{
+   */
+  /**
+   * Get the link I/O switch time calibration.
+   *
+   * \return the average microseconds to switch the pin between INPUT and OUTPUT measured in begin().
+   */
+  inline uint16_t getSwitchTime(void) { return(_link._switchTime); }
+
+  /**
+   * Get the link I/O write time calibration.
+   *
+   * \return the average microseconds to write the pin measured in begin().
+   */
+  inline uint16_t getWriteTime(void) { return(_link._writeTime); }
+
+  /**
+   * Benchmark the link at the current timeslot.
+   *
+   * Run count transactions of the specified type back to back. If noReset
+   * is true the transactions are sent without the Comms Reset signal as one
+   * continuous stream, and presence is only checked by the first transaction.
+   *
+   * \param op      the type of transactions to run.
+   * \param count   the number of transactions to run.
+   * \param res     the result of the benchmark.
+   * \param noReset set true to omit the Comms Reset signal. Defaults to false (ie, reset).
+   */
+  void run(benchOp_t op, uint16_t count, result_t &res, bool noReset = false);
+
+  /**
+   * Benchmark the link over a list of timeslot values.
+   *
+   * For each timeslot the link is changed with MD_OnePin::setTimeslot() and
+   * the benchmark run() with the result stored in the matching index in the
+   * result array. If a timeslot is not accepted, because it is outside 
+   * OPT_MIN to OPT_MAX or the SEC refuses it, it is not measured and count
+   * is 0 in the result for that timeslot. The original timeslot is 
+   * restored at the end.
+   *
+   * \param op      the type of transactions to run.
+   * \param count   the number of transactions to run for each timeslot.
+   * \param t       array of the timeslot values to benchmark.
+   * \param tCount  the number of entries in the timeslot array.
+   * \param res     array of results, one for each timeslot.
+   */
+  void sweep(benchOp_t op, uint16_t count, const uint16_t t[], uint8_t tCount, result_t res[]);
+
+  /** @} */
+
+private:
+  MD_OnePin &_link;   ///< the link being benchmarked
+  uint16_t _top[OPB_TOP_SIZE];  ///< slowest transaction times, in descending order
+
+  void addTop(uint16_t lat, uint8_t size);  ///< Keep lat if it is one of the size slowest
+};
@@ -0,0 +1,221 @@
+#include <MD_OnePinGroup.h>
+
+/**
+ * \file
+ * \brief Code file for MD_OnePinGroup multi-link class (PRI implementation).
+ */
+
+void MD_OnePinGroup::begin(void)
+{
+  for (uint8_t i = 0; i < _count; i++)
+    _link[i]->begin();
+
+#if OP_FAST_IO
+  // All the links must be on the same port for lockstep.
+  // The combined mask is used for signals common to all links.
+  _lockstep = (_count != 0);
+  if (_lockstep)
+  {
+    _io = _link[0]->_io;
+    _io.mask = 0;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+      if (_link[i]->_io.out != _io.out || (_io.mask & _link[i]->_io.mask))
+        _lockstep = false;    // different port or same pin twice
+      _io.mask |= _link[i]->_io.mask;
+    }
+  }
+#endif
+}
+
+#if OP_FAST_IO
+opIoReg_t MD_OnePinGroup::resetComm(void)
+{
+  const opTiming_t &tm = _link[0]->_tm;
+  uint16_t writeTime = _link[0]->_writeTime;
+  uint16_t switchTime = _link[0]->_switchTime;
+  opIoReg_t present;
+  opIrqState_t irq;
+
+  opTimeStart(_deadline);
+  irq = opIrqSave();
+  opIoSet(_io.dir, _io.mask);
+  opIoClr(_io.out, _io.mask);
+  opTimeWait(_deadline, tm.rstSignal, writeTime);
+  opIoSet(_io.out, _io.mask);
+  opIoClr(_io.dir, _io.mask);
+  opTimeWait(_deadline, tm.rstPrsSample, switchTime);
+  present = ~(*_io.in) & _io.mask;    // present SEC pull their link LOW
+  opIoSet(_io.dir, _io.mask);
+  opIrqRestore(irq);
+  opTimeWait(_deadline, tm.rstEnd, switchTime);
+
+  for (uint8_t i = 0; i < _count; i++)
+    _link[i]->_presence = ((present & _link[i]->_io.mask) != 0);
+
+  return(present);
+}
+#endif
+
+bool MD_OnePinGroup::write(const MD_OnePin::packet_t data[], bool noReset)
+{
+  return(writeLinks(data, 1, noReset));
+}
+
+bool MD_OnePinGroup::broadcastWrite(MD_OnePin::packet_t data, bool noReset)
+{
+  return(writeLinks(&data, 0, noReset));
+}
+
+bool MD_OnePinGroup::writeLinks(const MD_OnePin::packet_t data[], uint8_t step, bool noReset)
+{
+  bool allPresent = true;
+
+#if OP_FAST_IO
+  // lockstep writes only use the 1 bit encoding without CRC or attention 
+  // mode, with all links at the same T
+  bool simple = true;
+
+  for (uint8_t i = 0; i < _count; i++)
+    if (_link[i]->_encoding != MD_OnePin::ENC_1BIT || _link[i]->_crc || _link[i]->_attnMode ||
+        !sameTiming(_link[i])) 
+      simple = false;
+
+  if (_lockstep && simple)
+  {
+    const opTiming_t &tm = _link[0]->_tm;
+    uint16_t writeTime = _link[0]->_writeTime;
+    opIoReg_t active;
+
+    opTimeStart(_deadline);   // the deadline may be stale with noReset
+    active = noReset ? _io.mask : resetComm();
+
+    // send out each bit in turn, LSB first
+    for (uint8_t bit = 0; ; bit++)
+    {
+      opIoReg_t ones = 0;
+      opIrqState_t irq;
+
+      // drop out links that have sent all their bits and
+      // work out which of the rest are sending a 1
+      for (uint8_t i = 0; i < _count; i++)
+      {
+        if (bit >= _link[i]->_bppPri)
+          active &= ~_link[i]->_io.mask;
+        else if (data[i * step] & ((MD_OnePin::packet_t)1 << bit))
+          ones |= _link[i]->_io.mask;
+      }
+      ones &= active;
+      if (active == 0) break;
+
+      // All links go LOW together. Links sending a 1 are released at
+      // the end of the Write 1 signal, the others at the end of the
+      // Write 0 signal. When all the bits are the same just send the
+      // normal signal for all of them.
+      irq = opIrqSave();
+      opTimeCatchUp(_deadline);
+      opIoClr(_io.out, active);
+      if (ones == active)
+      {
+        opTimeWait(_deadline, tm.wr1Signal, writeTime);
+        opIoSet(_io.out, active);
+        opIrqRestore(irq);
+        opTimeWait(_deadline, tm.wr1Pause, writeTime);
+      }
+      else if (ones == 0)
+      {
+        opTimeWait(_deadline, tm.wr0Signal, writeTime);
+        opIoSet(_io.out, active);
+        opIrqRestore(irq);
+        opTimeWait(_deadline, tm.wr0Pause, writeTime);
+      }
+      else
+      {
+        opTimeWait(_deadline, tm.wr1Signal, writeTime);
+        opIoSet(_io.out, ones);
+        opTimeWait(_deadline, tm.wr0Signal - tm.wr1Signal, writeTime);
+        opIoSet(_io.out, active & ~ones);
+        opIrqRestore(irq);
+        opTimeWait(_deadline, tm.wr0Pause, writeTime);
+      }
+    }
+  }
+  else
+#endif
+  {
+    for (uint8_t i = 0; i < _count; i++)
+      _link[i]->write(data[i * step], noReset);
+  }
+
+  for (uint8_t i = 0; i < _count; i++)
+    if (!_link[i]->isPresent()) allPresent = false;
+
+  return(allPresent);
+}
+
+bool MD_OnePinGroup::read(MD_OnePin::packet_t data[], bool noReset)
+{
+  bool allPresent = true;
+
+#if OP_FAST_IO
+  // lockstep reads are only used without CRC or attention mode, with all
+  // links at the same T
+  bool simple = true;
+
+  for (uint8_t i = 0; i < _count; i++)
+    if (_link[i]->_crc || _link[i]->_attnMode || !sameTiming(_link[i])) simple = false;
+
+  if (_lockstep && simple)
+  {
+    const opTiming_t &tm = _link[0]->_tm;
+    uint16_t writeTime = _link[0]->_writeTime;
+    uint16_t switchTime = _link[0]->_switchTime;
+    opIoReg_t active;
+
+    opTimeStart(_deadline);   // the deadline may be stale with noReset
+    active = noReset ? _io.mask : resetComm();
+
+    for (uint8_t i = 0; i < _count; i++)
+      data[i] = (active & _link[i]->_io.mask) ? 0 : 0xffffffff;
+
+    // receive each bit in turn, LSB first
+    for (uint8_t bit = 0; ; bit++)
+    {
+      opIoReg_t in;
+      opIrqState_t irq;
+
+      // drop out links that have received all their bits
+      for (uint8_t i = 0; i < _count; i++)
+        if (bit >= _link[i]->_bppSec) active &= ~_link[i]->_io.mask;
+      if (active == 0) break;
+
+      irq = opIrqSave();
+      opTimeCatchUp(_deadline);
+      opIoClr(_io.out, active);
+      opTimeWait(_deadline, tm.rdInit, writeTime);
+      opIoSet(_io.out, active);
+      opIoClr(_io.dir, active);
+      opTimeWait(_deadline, tm.rdSample, switchTime);
+      in = *_io.in;
+      opIoSet(_io.dir, active);
+      opIrqRestore(irq);
+
+      for (uint8_t i = 0; i < _count; i++)
+        if (active & in & _link[i]->_io.mask)
+          data[i] |= ((MD_OnePin::packet_t)1 << bit);
+
+      opTimeWait(_deadline, tm.rdPause, switchTime);
+    }
+  }
+  else
+#endif
+  {
+    for (uint8_t i = 0; i < _count; i++)
+      data[i] = _link[i]->read(noReset);
+  }
+
+  for (uint8_t i = 0; i < _count; i++)
+    if (!_link[i]->isPresent()) allPresent = false;
+
+  return(allPresent);
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <MD_OnePin.h>
+
+/**
+ * \file
+ * \brief Header file and class definition for the MD_OnePinGroup multi-link object.
+ */
+
+/**
+ * Multi-link object for the MD_OnePin library.
+ *
+ * A group runs the signaling for a set of MD_OnePin links in lockstep, so
+ * that transactions with N SEC devices take about the same time as one.
+ * Every signal edge is generated for all the links in the group with a
+ * single port register write, and all the links are sampled with a single
+ * port register read.
+ *
+ * Lockstep operation requires OP_FAST_IO to be enabled and all the links
+ * to be on the same I/O port. When this is not the case the group works
+ * through the links one after the other using the normal MD_OnePin methods.
+ *
+ * The links may each have a different bits per packet (bpp). During the
+ * data phase links drop out of the lockstep as they complete their packet.
+ * All the links in lockstep use the timing of the first link in the link
+ * array. Lockstep is only used when all the links are at the same timeslot
+ * T and no links use CRC or attention mode, and lockstep writes only when
+ * all the links use the MD_OnePin::ENC_1BIT encoding.
+ *
+ * \sa \ref pageImplementation
+ */
+class MD_OnePinGroup
+{
+public:
+  //--------------------------------------------------------------
+  /** \name Class constructor and destructor.
+   * @{
+   */
+  /**
+   * Class Constructor
+   *
+   * Instantiate a new instance of the class. The array of links supplied is
+   * not copied and needs to remain in scope for the life of the group.
+   *
+   * \param link  array of pointers to the MD_OnePin links in the group.
+   * \param count the number of links in the array.
+   */
+  MD_OnePinGroup(MD_OnePin *link[], uint8_t count) :
+    _link(link), _count(count), _lockstep(false)
+#if OP_FAST_IO
+    , _deadline(0)
+#endif
+    {};
+
+  /**
+   * Class Destructor.
+   *
+   * Release any allocated memory and clean up anything else.
+   */
+  ~MD_OnePinGroup() {};
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for core object control.
+   * @{
+   */
+  /**
+   * Initialize the object.
+   *
+   * Initialize all the links in the group (ie, call begin() for each link)
+   * and work out if the group can run in lockstep. This needs to be called
+   * during setup() instead of the begin() method for each link.
+   */
+  void begin(void);
+
+  /**
+   * Check if the group runs in lockstep.
+   *
+   * \return true if the group signals all the links at the same time.
+   */
+  inline bool isLockstep(void) { return(_lockstep); }
+
+  /**
+   * Write a PRI data packet to every link.
+   *
+   * Each link is sent its own data packet, with the packet for the link at
+   * index i in the link array taken from index i in the data array.
+   *
+   * \sa MD_OnePin::write(), MD_OnePin::isPresent()
+   *
+   * \param data    array of data packets, one for each link in the group.
+   * \param noReset set true to omit the Comms Reset signal before sending data. Defaults to false (ie, reset).
+   * \return true if all the SEC devices were present. Use isPresent() for each link for details.
+   */
+  bool write(const MD_OnePin::packet_t data[], bool noReset = false);
+
+  /**
+   * Write the same PRI data packet to every link.
+   *
+   * Used for commands to all the SEC devices (eg, latch all outputs). In
+   * lockstep the signals for all the links are sent once, so the write
+   * takes the time of one packet and every SEC receives the last bit at
+   * the same time. Otherwise the links are written one after the other.
+   *
+   * \sa write(), MD_OnePin::isPresent()
+   *
+   * \param data    the data packet sent to all the SEC devices.
+   * \param noReset set true to omit the Comms Reset signal before sending data. Defaults to false (ie, reset).
+   * \return true if all the SEC devices were present. Use isPresent() for each link for details.
+   */
+  bool broadcastWrite(MD_OnePin::packet_t data, bool noReset = false);
+
+  /**
+   * Request a SEC data packet from every link.
+   *
+   * The packet received from the link at index i in the link array is
+   * returned in index i of the data array.
+   *
+   * \sa MD_OnePin::read(), MD_OnePin::isPresent()
+   *
+   * \param data    array for the packets received, one for each link in the group.
+   * \param noReset set true to omit the Comms Reset signal before reading data. Defaults to false (ie, reset).
+   * \return true if all the SEC devices were present. Use isPresent() for each link for details.
+   */
+  bool read(MD_OnePin::packet_t data[], bool noReset = false);
+
+  /** @} */
+
+private:
+  MD_OnePin **_link;  ///< the links in this group
+  uint8_t _count;     ///< the number of links in the group
+  bool _lockstep;     ///< true if the links can all be signaled together
+
+  bool writeLinks(const MD_OnePin::packet_t data[], uint8_t step, bool noReset);  ///< write data[i * step] to link i
+
+#if OP_FAST_IO
+  opIo_t _io;         ///< the shared port registers, mask is all links in the group
+  opTick_t _deadline; ///< deadline for the current transaction wait
+
+  opIoReg_t resetComm(void);  ///< Reset all links together and return the mask of links present
+
+  /// true if the link uses the same timing as the first link, which times the lockstep signals
+  inline bool sameTiming(const MD_OnePin *link) 
+    { return(link->_tm.t == _link[0]->_tm.t && link->_overdrive == _link[0]->_overdrive); }
+#endif
+};
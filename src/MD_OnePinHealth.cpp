@@ -0,0 +1,118 @@
+#include <MD_OnePinHealth.h>
+
+/**
+ * \file
+ * \brief Code file for MD_OnePinHealth link health monitor class (PRI implementation).
+ */
+
+void MD_OnePinHealth::clear(void)
+{
+  newWindow();
+  _tPrev = 0;
+  _fallbacks = 0;
+  _cleanNeeded = OPH_CLEAN_COUNT;
+}
+
+void MD_OnePinHealth::newWindow(void)
+{
+  _window = 0;
+  _count = _errors = 0;
+  _clean = 0;
+}
+
+void MD_OnePinHealth::backOff(void)
+{
+  if (_cleanNeeded <= OPH_CLEAN_MAX / 2)
+    _cleanNeeded *= 2;
+  else
+    _cleanNeeded = OPH_CLEAN_MAX;
+}
+
+void MD_OnePinHealth::stepUp(void)
+{
+  uint16_t t = _link.getTimeslot();
+
+  // Nowhere to go (eg, SEC unplugged), so just keep counting at this T
+  if (_tPrev == 0 && t >= _tMax)
+  {
+    newWindow();
+    return;
+  }
+
+  // A failure soon after a step down goes straight back to the last good T.
+  // Either way, wait longer before the next try at a smaller T.
+  if (_tPrev != 0)
+    t = _tPrev;
+  else
+    t += (t >= 8 ? t / 8 : 1);
+  if (t > _tMax) t = _tMax;
+  backOff();
+  _tPrev = 0;
+  if (_link.setTimeslot(t)) _fallbacks++;   // SEC may not be there to change
+  newWindow();
+}
+
+void MD_OnePinHealth::stepDown(void)
+{
+  uint16_t t = _link.getTimeslot();
+  uint16_t tNew = t - (t >= 8 ? t / 8 : 1);
+
+  if (t <= 1 || tNew < _tMin)   // already as small as allowed
+  {
+    _clean = 0;
+    return;
+  }
+
+  // check the new T with test frames before using it for data
+  if (_link.testTimeslot(tNew))
+    _tPrev = t;
+  else
+  {
+    _link.setTimeslot(t);
+    backOff();
+  }
+  newWindow();
+}
+
+void MD_OnePinHealth::record(bool ok)
+{
+  // slide the window along, dropping the oldest result when full
+  if (_count < 32)
+    _count++;
+  else if (_window & 0x80000000UL)
+    _errors--;
+  _window = (_window << 1) | (ok ? 0 : 1);
+
+  if (!ok)
+  {
+    _errors++;
+    _clean = 0;
+  }
+  else if (_clean < 0xffff)
+    _clean++;
+
+  if (_errors >= OPH_ERR_LIMIT)
+    stepUp();
+  else if (_tPrev != 0 && _count >= 32)   // a full window at the new T, so keep it
+    _tPrev = 0;
+  else if (_clean >= _cleanNeeded)
+    stepDown();
+}
+
+bool MD_OnePinHealth::write(MD_OnePin::packet_t data, bool noReset)
+{
+  bool ok = _link.write(data, noReset);
+
+  record(ok);
+
+  return(ok);
+}
+
+MD_OnePin::packet_t MD_OnePinHealth::read(bool noReset)
+{
+  MD_OnePin::packet_t data = _link.read(noReset);
+
+  record(_link.isPresent() && _link.isCrcOk());
+
+  return(data);
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <MD_OnePin.h>
+
+/**
+ * \file
+ * \brief Header file and class definition for the MD_OnePinHealth link health monitor.
+ */
+
+/**
+\def OPH_ERR_LIMIT
+The number of failed transactions in the last 32 that makes the monitor
+move the link to a larger timeslot T.
+*/
+#ifndef OPH_ERR_LIMIT
+#define OPH_ERR_LIMIT 3
+#endif
+
+/**
+\def OPH_CLEAN_COUNT
+The number of consecutive good transactions before the monitor tries a
+smaller timeslot T.
+*/
+#ifndef OPH_CLEAN_COUNT
+#define OPH_CLEAN_COUNT 256
+#endif
+
+/**
+\def OPH_CLEAN_MAX
+The largest number of consecutive good transactions needed before trying
+a smaller timeslot T, after tries have failed.
+*/
+#ifndef OPH_CLEAN_MAX
+#define OPH_CLEAN_MAX 8192
+#endif
+
+/**
+ * Link health monitor for the MD_OnePin library.
+ *
+ * The monitor keeps the result of the last 32 transactions on a link. A
+ * transaction fails if SEC is not present or a packet fails its CRC check.
+ * When the failures in the window reach OPH_ERR_LIMIT the monitor moves
+ * the link to a larger T (by 1/8, as for MD_OnePin::negotiate()). The Sync
+ * signal for the change also brings back a SEC that has restarted at the
+ * default timeslot.
+ *
+ * After OPH_CLEAN_COUNT good transactions in a row the monitor tries a T
+ * 1/8 smaller, first checking it with test frames. If the check fails, or
+ * the link fails at the new T before the next 32 transactions are done,
+ * the link goes back to the previous T and the number of good
+ * transactions needed before the next try is doubled, up to OPH_CLEAN_MAX.
+ * So the link runs close to the smallest T that the wiring supports, and
+ * does not keep trying a T that is marginal.
+ *
+ * Transactions are recorded by using the write() and read() methods of the
+ * monitor, or by passing the result of other transactions to record(). The
+ * SEC needs to support timeslot changes and test frames.
+ *
+ * \sa \ref pageImplementation
+ */
+class MD_OnePinHealth
+{
+public:
+  //--------------------------------------------------------------
+  /** \name Class constructor and destructor.
+   * @{
+   */
+  /**
+   * Class Constructor
+   *
+   * Instantiate a new instance of the class for a link. The link needs to
+   * be initialized with begin() before it is used.
+   *
+   * \param link the MD_OnePin link to monitor.
+   * \param tMin the smallest T to try, in microseconds. Defaults to OPT_MIN, and is not less than OPT_MIN.
+   * \param tMax the largest T to use, in microseconds. Defaults to OPT, and is not more than OPT_MAX.
+   */
+  MD_OnePinHealth(MD_OnePin &link, uint16_t tMin = OPT_MIN, uint16_t tMax = OPT) :
+    _link(link), _tMin(tMin < OPT_MIN ? OPT_MIN : tMin), _tMax(tMax > OPT_MAX ? OPT_MAX : tMax)
+    { clear(); };
+
+  /**
+   * Class Destructor.
+   *
+   * Release any allocated memory and clean up anything else.
+   */
+  ~MD_OnePinHealth() {};
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for monitored transactions.
+   * @{
+   */
+  /**
+   * Write a PRI data packet and record the result.
+   *
+   * \sa MD_OnePin::write()
+   *
+   * \param data    the data to sent to the SEC.
+   * \param noReset set true to omit the Comms Reset signal before sending data. Defaults to false (ie, reset).
+   * \return true if the SEC device was present.
+   */
+  bool write(MD_OnePin::packet_t data, bool noReset = false);
+
+  /**
+   * Request a SEC data packet and record the result.
+   *
+   * \sa MD_OnePin::read()
+   *
+   * \param noReset set true to omit the Comms Reset signal before reading data. Defaults to false (ie, reset).
+   * \return Data packet received from the SEC.
+   */
+  MD_OnePin::packet_t read(bool noReset = false);
+
+  /**
+   * Record the result of a transaction.
+   *
+   * Used for transactions not run through the monitor (eg,
+   * MD_OnePin::transact()). The link T may be changed before this returns.
+   *
+   * \param ok true if the transaction succeeded.
+   */
+  void record(bool ok);
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for health status.
+   * @{
+   */
+  /**
+   * Get the failed transactions in the window.
+   *
+   * \return the number of the last getCount() transactions that failed.
+   */
+  inline uint8_t getErrors(void) { return(_errors); }
+
+  /**
+   * Get the number of transactions in the window.
+   *
+   * \return the number of transactions recorded at the current T, up to 32.
+   */
+  inline uint8_t getCount(void) { return(_count); }
+
+  /**
+   * Get the number of times T has been made larger.
+   *
+   * \return the number of times T was moved up because of failures.
+   */
+  inline uint16_t getFallbacks(void) { return(_fallbacks); }
+
+  /**
+   * Clear the transaction history.
+   *
+   * The window and counters are cleared, and the wait before trying a
+   * smaller T is set back to OPH_CLEAN_COUNT. The link T is not changed.
+   */
+  void clear(void);
+
+  /** @} */
+
+private:
+  MD_OnePin &_link;       ///< the link being monitored
+  uint16_t _tMin;         ///< smallest T to try
+  uint16_t _tMax;         ///< largest T to use
+  uint32_t _window;       ///< last 32 transactions, bit set for each failure
+  uint8_t  _count;        ///< transactions in the window
+  uint8_t  _errors;       ///< failures in the window
+  uint16_t _clean;        ///< consecutive good transactions
+  uint16_t _cleanNeeded;  ///< good transactions needed before trying a smaller T
+  uint16_t _tPrev;        ///< T before the last step down, 0 if it has been confirmed
+  uint16_t _fallbacks;    ///< number of times T was made larger
+
+  void newWindow(void);   ///< start a new window after a T change
+  void stepUp(void);      ///< move to a larger T after failures
+  void stepDown(void);    ///< try a smaller T after good transactions
+  void backOff(void);     ///< wait longer before trying a smaller T again
+};
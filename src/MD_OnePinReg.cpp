@@ -0,0 +1,34 @@
+#include <MD_OnePinReg.h>
+
+/**
+ * \file
+ * \brief Code file for MD_OnePinReg register access class (PRI implementation).
+ */
+
+bool MD_OnePinReg::writeReg(uint8_t reg, MD_OnePin::packet_t value)
+{
+  return(_link.write(OPR_CMD(_link._bppPri, OPR_WRITE, reg, value)));
+}
+
+bool MD_OnePinReg::readReg(uint8_t reg, MD_OnePin::packet_t &value)
+{
+  return(_link.transact(OPR_CMD(_link._bppPri, OPR_READ, reg, 0), value));
+}
+
+bool MD_OnePinReg::readRegs(uint8_t reg, uint8_t count, MD_OnePin::packet_t *buf)
+{
+  bool ok;
+
+  if (count == 0) return(true);
+
+  ok = _link.transact(OPR_CMD(_link._bppPri, OPR_READN, reg, count), buf[0]);
+  if (!ok)
+  {
+    for (uint8_t i = 1; i < count; i++)
+      buf[i] = 0xffffffff;
+    return(false);
+  }
+
+  // the rest follow straight on in the same transaction
+  return(_link.readStream(&buf[1], count - 1, true));
+}
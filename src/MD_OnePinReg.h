@@ -0,0 +1,100 @@
+#pragma once
+
+#include <MD_OnePin.h>
+
+/**
+ * \file
+ * \brief Header file and class definition for the MD_OnePinReg register access object.
+ */
+
+/**
+ * Register access object for the MD_OnePin library.
+ *
+ * Many SEC devices expose a small set of registers (eg, rate, mode,
+ * counters). This object reads and writes SEC registers by number using
+ * the register protocol (see "Register Access" in \ref pageLinkSignals),
+ * so each product does not need its own packet layout. A register read is
+ * one write-read transaction, and a number of consecutive registers can be
+ * read in one transaction with readRegs().
+ *
+ * The SEC needs to support the register protocol, eg the packaged SEC
+ * with a register table set by opsSetRegisters(). The PRI packet needs to
+ * be at least OPR_OP_BITS + OPR_REG_BITS bits, and the bits that are left
+ * are the largest value that can be written (24 bits for 32 bit packets).
+ * Register values are read as SEC packets.
+ *
+ * \sa \ref pageImplementation
+ */
+class MD_OnePinReg
+{
+public:
+  //--------------------------------------------------------------
+  /** \name Class constructor and destructor.
+   * @{
+   */
+  /**
+   * Class Constructor
+   *
+   * Instantiate a new instance of the class for a link. The link needs to
+   * be initialized with begin() before it is used.
+   *
+   * \param link the MD_OnePin link the SEC is connected to.
+   */
+  MD_OnePinReg(MD_OnePin &link) : _link(link) {};
+
+  /**
+   * Class Destructor.
+   *
+   * Release any allocated memory and clean up anything else.
+   */
+  ~MD_OnePinReg() {};
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for register access.
+   * @{
+   */
+  /**
+   * Write a SEC register.
+   *
+   * The register number and value are sent in one PRI packet. Only the low
+   * OPR_VALUE_BITS() bits of the value are sent.
+   *
+   * \param reg   the register number, 0 to (1 << OPR_REG_BITS) - 1.
+   * \param value the value to write.
+   * \return true if the SEC device was present (and the CRC check passed).
+   */
+  bool writeReg(uint8_t reg, MD_OnePin::packet_t value);
+
+  /**
+   * Read a SEC register.
+   *
+   * The register number is written and the value read back in one
+   * write-read transaction (MD_OnePin::transact()).
+   *
+   * \param reg   the register number, 0 to (1 << OPR_REG_BITS) - 1.
+   * \param value the register value. Set to 0xffffffff if it could not be read.
+   * \return true if the value was read correctly.
+   */
+  bool readReg(uint8_t reg, MD_OnePin::packet_t &value);
+
+  /**
+   * Read consecutive SEC registers in one transaction.
+   *
+   * The first register is read as for readReg() and the rest follow as a
+   * stream of packets (MD_OnePin::readStream()) with no Reset between
+   * them, so all the registers are read after one Reset/Presence.
+   *
+   * \param reg   the first register number.
+   * \param count the number of registers to read, up to OPR_VALUE_MASK() of the PRI packet.
+   * \param buf   the buffer for count register values. Set to 0xffffffff if they could not be read.
+   * \return true if all the values were read correctly.
+   */
+  bool readRegs(uint8_t reg, uint8_t count, MD_OnePin::packet_t *buf);
+
+  /** @} */
+
+private:
+  MD_OnePin &_link;   ///< the link the SEC is connected to
+};
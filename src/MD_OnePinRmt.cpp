@@ -0,0 +1,312 @@
+#include <MD_OnePinRmt.h>
+
+/**
+ * \file
+ * \brief Code file for MD_OnePinRmt hardware waveform class (PRI implementation).
+ */
+
+#if OP_RMT
+
+#ifndef OPRMT_TIMEOUT
+#define OPRMT_TIMEOUT 2000  ///< microseconds allowed past the expected end of a blocking transaction
+#endif
+
+bool MD_OnePinRmt::begin(void)
+{
+  rmt_rx_channel_config_t rxCfg = {};
+  rmt_tx_channel_config_t txCfg = {};
+  rmt_copy_encoder_config_t encCfg = {};
+  rmt_rx_event_callbacks_t cbs = {};
+  bool ok;
+
+  if (_tx != nullptr) return(true);   // already set up
+
+  // The receive channel is set up first. The transmit channel then
+  // drives the same pin open drain and loops its output back to the
+  // receive channel, so the capture is the combined PRI and SEC signals.
+  rxCfg.gpio_num = (gpio_num_t)_pin;
+  rxCfg.clk_src = RMT_CLK_SRC_DEFAULT;
+  rxCfg.resolution_hz = OPRMT_RESOLUTION;
+  rxCfg.mem_block_symbols = OPRMT_RX_SYMBOLS;
+
+  txCfg.gpio_num = (gpio_num_t)_pin;
+  txCfg.clk_src = RMT_CLK_SRC_DEFAULT;
+  txCfg.resolution_hz = OPRMT_RESOLUTION;
+  txCfg.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+  txCfg.trans_queue_depth = 1;
+  txCfg.flags.io_loop_back = 1;
+  txCfg.flags.io_od_mode = 1;
+
+  cbs.on_recv_done = rxDone;
+
+  ok = (rmt_new_rx_channel(&rxCfg, &_rx) == ESP_OK)
+    && (rmt_new_tx_channel(&txCfg, &_tx) == ESP_OK)
+    && (rmt_new_copy_encoder(&encCfg, &_copy) == ESP_OK)
+    && (rmt_rx_register_event_callbacks(_rx, &cbs, this) == ESP_OK)
+    && (rmt_enable(_rx) == ESP_OK)
+    && (rmt_enable(_tx) == ESP_OK);
+
+  if (ok)
+    gpio_pullup_en((gpio_num_t)_pin);
+  else
+    end();
+
+  return(ok);
+}
+
+void MD_OnePinRmt::end(void)
+{
+  // disabling a channel that is not enabled just returns an error
+  if (_tx != nullptr)
+  {
+    rmt_disable(_tx);
+    rmt_del_channel(_tx);
+    _tx = nullptr;
+  }
+  if (_rx != nullptr)
+  {
+    rmt_disable(_rx);
+    rmt_del_channel(_rx);
+    _rx = nullptr;
+  }
+  if (_copy != nullptr)
+  {
+    rmt_del_encoder(_copy);
+    _copy = nullptr;
+  }
+  _busy = false;
+}
+
+void MD_OnePinRmt::newTransaction(bool isRead, bool noReset)
+{
+  _txCount = _smpCount = 0;
+  _txTime = 0;
+  _maxHigh = 0;
+  _isRead = isRead;
+  _noReset = noReset;
+}
+
+void MD_OnePinRmt::addSignal(uint16_t low, uint16_t high, uint16_t sample)
+{
+  rmt_symbol_word_t &s = _txBuf[_txCount++];
+
+  // The link is released (open drain HIGH) for the high time. A HIGH
+  // duration of 0 would end the transmission, so it is at least 1 tick.
+  if (high == 0) high = 1;
+  s.level0 = 0;
+  s.duration0 = low;
+  s.level1 = 1;
+  s.duration1 = high;
+
+  if (sample != 0) _smpAt[_smpCount++] = _txTime + low + sample;
+  _txTime += low + high;
+  if (high > _maxHigh) _maxHigh = high;
+}
+
+void MD_OnePinRmt::addReset(void)
+{
+  addSignal(OPT_RST_SIGNAL_T(_t), OPT_RST_PRS_SAMPLE_T(_t) + OPT_RST_END_T(_t), OPT_RST_PRS_SAMPLE_T(_t));
+}
+
+bool MD_OnePinRmt::startTransfer(void)
+{
+  rmt_receive_config_t rxCfg = {};
+  rmt_transmit_config_t txCfg = {};
+
+  if (_tx == nullptr) return(false);
+
+  // The capture ends when the link has been HIGH for longer than any
+  // HIGH time in the transaction.
+  rxCfg.signal_range_min_ns = OPRMT_GLITCH_NS;
+  rxCfg.signal_range_max_ns = ((uint32_t)_maxHigh + _t) * 1000;
+  txCfg.loop_count = 0;
+  txCfg.flags.eot_level = 1;    // leave the link released
+
+  _busy = true;
+  if (rmt_receive(_rx, _rxBuf, sizeof(_rxBuf), &rxCfg) != ESP_OK)
+  {
+    _busy = false;
+    return(false);
+  }
+  if (rmt_transmit(_tx, _copy, _txBuf, _txCount * sizeof(rmt_symbol_word_t), &txCfg) != ESP_OK)
+  {
+    // cancel the capture
+    rmt_disable(_rx);
+    rmt_enable(_rx);
+    _busy = false;
+    return(false);
+  }
+
+  return(true);
+}
+
+bool MD_OnePinRmt::waitTransfer(void)
+{
+  uint32_t start = micros();
+  uint32_t limit = _txTime + _maxHigh + _t + OPRMT_TIMEOUT;
+
+  while (_busy)
+  {
+    if (micros() - start > limit)
+    {
+      // no capture complete, so cancel it
+      rmt_disable(_rx);
+      rmt_enable(_rx);
+      _busy = false;
+      _presence = false;
+      return(false);
+    }
+  }
+
+  return(true);
+}
+
+uint64_t MD_OnePinRmt::decode(size_t count)
+{
+  uint64_t samples = 0;
+  uint32_t edge = 0;    // time the current captured level ends
+  size_t level = 0;     // current captured level, 2 for each symbol word
+
+  // The capture starts at the first falling edge, which is the start of
+  // the first signal, so the capture times line up with the sample times.
+  // After the end of the capture the link is idle HIGH.
+  for (uint8_t i = 0; i < _smpCount; i++)
+  {
+    bool high = true;
+
+    while (level < 2 * count)
+    {
+      const rmt_symbol_word_t &w = _rxBuf[level >> 1];
+      uint16_t d = (level & 1) ? w.duration1 : w.duration0;
+
+      if (d == 0)   // end of the capture
+      {
+        level = 2 * count;
+        break;
+      }
+      if (_smpAt[i] < edge + d)
+      {
+        high = (level & 1) ? w.level1 : w.level0;
+        break;
+      }
+      edge += d;
+      level++;
+    }
+    if (high) samples |= ((uint64_t)1 << i);
+  }
+
+  return(samples);
+}
+
+bool MD_OnePinRmt::rxDone(rmt_channel_handle_t ch, const rmt_rx_done_event_data_t *edata, void *ctx)
+{
+  MD_OnePinRmt *op = (MD_OnePinRmt *)ctx;
+  uint64_t samples = op->decode(edata->num_symbols);
+
+  (void)ch;
+
+  // the first sample is presence (LOW if present) unless there is no Reset
+  if (!op->_noReset)
+  {
+    op->_presence = ((samples & 1) == 0);
+    samples >>= 1;
+  }
+  if (op->_isRead)
+  {
+    if (!op->_noReset && !op->_presence)
+      op->_data = 0xffffffff;
+    else
+      op->_data = (packet_t)samples & ((op->_bppSec >= 32) ? 0xffffffff : (((packet_t)1 << op->_bppSec) - 1));
+  }
+
+  op->_busy = false;
+  if (op->_cbComplete != nullptr) op->_cbComplete(op, op->_data);
+
+  return(false);    // no task woken
+}
+
+bool MD_OnePinRmt::startWrite(packet_t data, bool noReset)
+{
+  if (_busy) return(false);
+
+  if (_bppPri < 32) data &= ((packet_t)1 << _bppPri) - 1;
+  newTransaction(false, noReset);
+  _data = data;
+  if (!noReset) addReset();
+
+  // send out each bit or symbol in turn, LSB first
+  if (_encoding == MD_OnePin::ENC_2BIT)
+  {
+    for (uint8_t i = 0; i < _bppPri; i += 2, data >>= 2)
+    {
+      uint8_t s = (_bppPri - i == 1) ? (data & 1) : (data & 3);   // the last symbol of an odd size packet carries 1 bit
+
+      addSignal(OPT_SYM_SIGNAL_T(_t, s), OPT_SYM_PAUSE_T(_t), 0);
+    }
+  }
+  else
+  {
+    for (uint8_t i = 0; i < _bppPri; i++, data >>= 1)
+    {
+      if (data & 1) addSignal(OPT_WR1_SIGNAL_T(_t), OPT_WR1_PAUSE_T(_t), 0);
+      else          addSignal(OPT_WR0_SIGNAL_T(_t), OPT_WR0_PAUSE_T(_t), 0);
+    }
+  }
+
+  return(startTransfer());
+}
+
+bool MD_OnePinRmt::startRead(bool noReset)
+{
+  if (_busy) return(false);
+
+  newTransaction(true, noReset);
+  if (!noReset) addReset();
+  for (uint8_t i = 0; i < _bppSec; i++)
+    addSignal(OPT_RD_INIT_T(_t), OPT_RD_SAMPLE_T(_t) + OPT_RD_PAUSE_T(_t), OPT_RD_SAMPLE_T(_t));
+
+  return(startTransfer());
+}
+
+bool MD_OnePinRmt::write(packet_t data, bool noReset)
+{
+  // The data bits are in the same transfer as the Reset signal, so unlike
+  // MD_OnePin they are sent even if SEC is not present (and not seen).
+  if (!startWrite(data, noReset) || !waitTransfer())
+    return(false);
+
+  return(_presence);
+}
+
+MD_OnePinRmt::packet_t MD_OnePinRmt::read(bool noReset)
+{
+  if (!startRead(noReset) || !waitTransfer())
+    return(0xffffffff);
+
+  return(_data);
+}
+
+bool MD_OnePinRmt::setTimeslot(uint16_t t)
+{
+  if (_busy) return(false);
+
+  // The Sync signal always uses the default timing
+  newTransaction(false, false);
+  addSignal(OPT_SYNC_SIGNAL, OPT_RST_PRS_SAMPLE + OPT_RST_END, OPT_RST_PRS_SAMPLE);
+  if (!startTransfer() || !waitTransfer())
+    return(false);
+
+  // now the Reset at the new timeslot, if SEC is there
+  _t = t;
+  if (_presence)
+  {
+    newTransaction(false, false);
+    addReset();
+    if (!startTransfer()) _presence = false;
+    else waitTransfer();
+  }
+
+  return(_presence);
+}
+
+#endif
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <MD_OnePin.h>
+
+/**
+ * \file
+ * \brief Header file and class definition for the MD_OnePinRmt hardware waveform link.
+ */
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_arduino_version.h>
+#endif
+
+/**
+\def OP_RMT
+Set to 1 by the library when MD_OnePinRmt is available, ie on ESP32
+processors with the RMT driver in the version 3 (ESP-IDF 5) Arduino core.
+The class is not defined for other processors.
+*/
+#if defined(ARDUINO_ARCH_ESP32) && defined(ESP_ARDUINO_VERSION_MAJOR) && (ESP_ARDUINO_VERSION_MAJOR >= 3)
+#define OP_RMT 1
+#else
+#define OP_RMT 0
+#endif
+
+#if OP_RMT
+#include <driver/rmt_tx.h>
+#include <driver/rmt_rx.h>
+
+#define OPRMT_RESOLUTION  1000000   ///< RMT tick rate in Hz, 1 tick per microsecond
+#define OPRMT_GLITCH_NS   1000      ///< captured pulses shorter than this are ignored
+#define OPRMT_TX_SYMBOLS  (1 + 32)  ///< Reset signal plus the largest packet
+#define OPRMT_RX_SYMBOLS  (2 * SOC_RMT_MEM_WORDS_PER_CHANNEL)  ///< capture memory, 2 RMT memory blocks
+
+static_assert(OPRMT_RX_SYMBOLS >= 2 * OPRMT_TX_SYMBOLS, "RMT capture memory is too small for a whole transaction");
+
+/**
+ * Hardware waveform variant of the MD_OnePin object (ESP32 RMT).
+ *
+ * The signals for a whole transaction are converted into a buffer of RMT
+ * symbols (one LOW and one HIGH duration for each signal) that the RMT
+ * peripheral clocks out with no CPU involvement. An RMT receive channel on
+ * the same pin captures the link waveform, including the SEC read responses
+ * and presence signal, and the capture is sampled at the same points in the
+ * transaction that MD_OnePin samples the pin. The pin is open drain with
+ * the pullup enabled, so SEC can pull the link LOW at any time.
+ *
+ * All the signal durations are clocked by the RMT hardware, so the
+ * timing is exact at any T and not affected by interrupts or other tasks.
+ * The smallest T is then only limited by SEC.
+ *
+ * The Reset/Presence, Write 0/1 (or 2 bit symbols), Read and Sync signals
+ * are supported, so write(), read() and setTimeslot() behave the same as
+ * MD_OnePin. Transactions can also be started without blocking with
+ * startWrite() and startRead(), and the result is passed to a callback
+ * from the capture complete interrupt. CRC, write-read transactions,
+ * frames and attention mode are not supported.
+ *
+ * The object uses one RMT transmit and one receive channel. The receive
+ * channel uses two RMT memory blocks.
+ *
+ * \sa \ref pageImplementation
+ */
+class MD_OnePinRmt
+{
+public:
+  typedef opPriPacket_t packet_t;    ///< The Primary side comms packet. Defined as max size to fit all supported types.
+
+  /**
+   * Non-blocking transaction completion callback function.
+   *
+   * The callback is invoked from the RMT capture complete interrupt when a
+   * transaction started using startWrite() or startRead() has completed,
+   * so it needs to be short.
+   *
+   * \param op   the object that has completed the transaction.
+   * \param data the data received for a read, the data sent for a write.
+   */
+  typedef void (*cbComplete_t)(MD_OnePinRmt *op, packet_t data);
+
+  //--------------------------------------------------------------
+  /** \name Class constructor and destructor.
+   * @{
+   */
+  /**
+   * Class Constructor
+   *
+   * Instantiate a new instance of the class.
+   *
+   * \sa MD_OnePin::MD_OnePin()
+   *
+   * \param pin pin used for OnePin comms.
+   * \param bppPri the number of bits per packet (bpp) sent by PRI
+   * \param bppSec the number of bits per packet (bpp) received from SEC
+   */
+  MD_OnePinRmt(uint8_t pin, uint8_t bppPri = BPP_PRI, uint8_t bppSec = BPP_SEC) :
+    _pin(pin), _bppPri(bppPri), _bppSec(bppSec), _t(OPT), _encoding(MD_OnePin::ENC_1BIT),
+    _presence(false), _tx(nullptr), _rx(nullptr), _copy(nullptr),
+    _busy(false), _cbComplete(nullptr)
+    {};
+
+  /**
+   * Class Destructor.
+   *
+   * Release the RMT channels.
+   */
+  ~MD_OnePinRmt() { end(); };
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for core object control.
+   * @{
+   */
+  /**
+   * Initialize the object.
+   *
+   * Allocate and enable the RMT channels for the comms pin. No I/O
+   * calibration is needed as the RMT hardware times all the signals.
+   *
+   * \return true if the RMT channels were set up, false if they are not available.
+   */
+  bool begin(void);
+
+  /**
+   * Release the RMT channels.
+   *
+   * The pin can then be used by other code (eg, an MD_OnePin object).
+   */
+  void end(void);
+
+  /**
+   * Write a PRI data packet.
+   *
+   * \sa MD_OnePin::write()
+   *
+   * \param data    the data to sent to the SEC. Only the configured number of bits will be transmitted.
+   * \param noReset set true to omit the Comms Reset signal before sending data. Defaults to false (ie, reset).
+   * \return true if the SEC device was present.
+   */
+  bool write(packet_t data, bool noReset = false);
+
+  /**
+   * Request a SEC data packet.
+   *
+   * \sa MD_OnePin::read()
+   *
+   * \param noReset set true to omit the Comms Reset signal before reading data. Defaults to false (ie, reset).
+   * \return Data packet received from the SEC. Only the configured number of bits will be valid.
+   */
+  packet_t read(bool noReset = false);
+
+  /**
+   * Secondary device presence status.
+   *
+   * \sa MD_OnePin::isPresent()
+   *
+   * \return true if the SEC was present at the last attempted comms.
+   */
+  inline bool isPresent(void) { return(_presence); }
+
+  /**
+   * Set the encoding for data written to SEC.
+   *
+   * \sa MD_OnePin::setEncoding()
+   *
+   * \param enc the encoding to use for writes.
+   */
+  inline void setEncoding(MD_OnePin::encoding_t enc) { _encoding = enc; }
+
+  /**
+   * Change the link timeslot T.
+   *
+   * \sa MD_OnePin::setTimeslot()
+   *
+   * \param t the new timeslot in microseconds.
+   * \return true if the SEC was present for the Sync signal.
+   */
+  bool setTimeslot(uint16_t t);
+
+  /**
+   * Get the link timeslot T.
+   *
+   * \return the current timeslot in microseconds.
+   */
+  inline uint16_t getTimeslot(void) { return(_t); }
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for non-blocking transactions.
+   * @{
+   */
+  /**
+   * Start a non-blocking PRI data packet write.
+   *
+   * Hand the signals for the same transaction as write() to the RMT
+   * hardware and return straight away. Completion is notified through the
+   * callback set by setCallback().
+   *
+   * \param data    the data to sent to the SEC. Only the configured number of bits will be transmitted.
+   * \param noReset set true to omit the Comms Reset signal before sending data. Defaults to false (ie, reset).
+   * \return true if the transaction was started, false if a transaction is already in progress.
+   */
+  bool startWrite(packet_t data, bool noReset = false);
+
+  /**
+   * Start a non-blocking SEC data packet request.
+   *
+   * Hand the signals for the same transaction as read() to the RMT
+   * hardware and return straight away. The received data is passed to
+   * the callback set by setCallback().
+   *
+   * \param noReset set true to omit the Comms Reset signal before reading data. Defaults to false (ie, reset).
+   * \return true if the transaction was started, false if a transaction is already in progress.
+   */
+  bool startRead(bool noReset = false);
+
+  /**
+   * Check if a non-blocking transaction is in progress.
+   *
+   * \return true if a transaction started by startWrite() or startRead() has not completed.
+   */
+  inline bool isBusy(void) { return(_busy); }
+
+  /**
+   * Set the non-blocking transaction completion callback.
+   *
+   * \sa cbComplete_t
+   *
+   * \param cb the callback function, nullptr to disable.
+   */
+  inline void setCallback(cbComplete_t cb) { _cbComplete = cb; }
+
+  /** @} */
+
+private:
+  uint8_t  _pin;        ///< pin used for OnePin comms
+  uint8_t  _bppPri;     ///< the number of bits per packet sent by PRI
+  uint8_t  _bppSec;     ///< the number of bits per packet received from SEC
+  uint16_t _t;          ///< the timeslot T
+  MD_OnePin::encoding_t _encoding; ///< encoding for data written to SEC
+  volatile bool _presence; ///< result of the last presence check (true if present)
+
+  rmt_channel_handle_t _tx;   ///< RMT transmit channel
+  rmt_channel_handle_t _rx;   ///< RMT receive channel, looped back from the transmit pin
+  rmt_encoder_handle_t _copy; ///< RMT encoder that copies the symbol buffer
+
+  // Transaction being clocked out
+  rmt_symbol_word_t _txBuf[OPRMT_TX_SYMBOLS]; ///< signals for the transaction
+  rmt_symbol_word_t _rxBuf[OPRMT_RX_SYMBOLS]; ///< captured link waveform
+  uint32_t _smpAt[OPRMT_TX_SYMBOLS];  ///< link sample times from the start of the transaction
+  uint8_t  _txCount;    ///< number of signals in _txBuf
+  uint8_t  _smpCount;   ///< number of sample times in _smpAt
+  uint32_t _txTime;     ///< length of the transaction so far in microseconds
+  uint16_t _maxHigh;    ///< longest HIGH time in the transaction
+  bool     _isRead;     ///< the transaction is a read
+  bool     _noReset;    ///< the transaction has no Reset signal
+  volatile packet_t _data; ///< data sent or received
+
+  volatile bool _busy;  ///< transaction in progress
+  cbComplete_t _cbComplete; ///< non-blocking transaction completion callback
+
+  void newTransaction(bool isRead, bool noReset);        ///< clear the signal buffer for a new transaction
+  void addSignal(uint16_t low, uint16_t high, uint16_t sample); ///< add a signal with a sample time (0 for none) after the LOW
+  void addReset(void);                 ///< add a Reset signal with the presence sample
+  bool startTransfer(void);            ///< start the RMT transmit and capture; false on error
+  bool waitTransfer(void);             ///< wait for the transaction to complete; false on timeout
+  uint64_t decode(size_t count);       ///< sample the captured waveform, bit n set if sample n was HIGH
+  static bool rxDone(rmt_channel_handle_t ch, const rmt_rx_done_event_data_t *edata, void *ctx); ///< RMT capture complete ISR callback
+};
+#endif
@@ -0,0 +1,98 @@
+#include <MD_OnePinService.h>
+
+/**
+ * \file
+ * \brief Code file for MD_OnePinService link service task class (PRI implementation).
+ */
+
+#if OP_SERVICE
+
+#if (OPSVC_QUEUE_SIZE & (OPSVC_QUEUE_SIZE - 1)) != 0
+#error OPSVC_QUEUE_SIZE must be a power of 2
+#endif
+
+bool MD_OnePinService::begin(BaseType_t core, UBaseType_t priority)
+{
+  if (_task != nullptr) return(true);   // already running
+
+  return(xTaskCreatePinnedToCore(run, "MD_OnePin", OPSVC_STACK_SIZE, this, priority, &_task, core) == pdPASS);
+}
+
+bool MD_OnePinService::submitWrite(request_t &req, uint8_t link, MD_OnePin::packet_t data, bool noReset, cbRequest_t cb)
+{
+  req.link = link;
+  req.isRead = false;
+  req.noReset = noReset;
+  req.data = data;
+  req.cb = cb;
+
+  return(submit(req));
+}
+
+bool MD_OnePinService::submitRead(request_t &req, uint8_t link, bool noReset, cbRequest_t cb)
+{
+  req.link = link;
+  req.isRead = true;
+  req.noReset = noReset;
+  req.cb = cb;
+
+  return(submit(req));
+}
+
+bool MD_OnePinService::submit(request_t &req)
+{
+  uint8_t next = (_head + 1) & (OPSVC_QUEUE_SIZE - 1);
+
+  if (_task == nullptr || req.link >= _count) return(false);
+  if (next == _tail) return(false);     // full
+
+  req.ok = false;
+  req.done = false;
+  _queue[_head] = &req;
+  __sync_synchronize();   // the request is complete before the other core sees it queued
+  _head = next;
+  xTaskNotifyGive(_task);
+
+  return(true);
+}
+
+void MD_OnePinService::serve(request_t &req)
+{
+  MD_OnePin *op = _link[req.link];
+
+  // No task switches on this core until the transaction is complete
+  vTaskSuspendAll();
+  if (req.isRead)
+  {
+    req.data = op->read(req.noReset);
+    req.ok = op->isPresent() && op->isCrcOk();
+  }
+  else
+    req.ok = op->write(req.data, req.noReset);
+  xTaskResumeAll();
+
+  if (req.cb != nullptr) req.cb(&req);
+  __sync_synchronize();   // the results are complete before the other core sees done
+  req.done = true;
+}
+
+void MD_OnePinService::run(void *arg)
+{
+  MD_OnePinService *svc = (MD_OnePinService *)arg;
+
+  for (uint8_t i = 0; i < svc->_count; i++)
+    svc->_link[i]->begin();
+
+  for (;;)
+  {
+    // wait for the application to queue a request
+    while (svc->_head == svc->_tail)
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    __sync_synchronize();
+    svc->serve(*svc->_queue[svc->_tail]);
+    svc->_tail = (svc->_tail + 1) & (OPSVC_QUEUE_SIZE - 1);
+  }
+}
+
+#endif
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <MD_OnePin.h>
+
+/**
+ * \file
+ * \brief Header file and class definition for the MD_OnePinService link service task.
+ */
+
+/**
+\def OP_SERVICE
+Set to 1 by the library when MD_OnePinService is available, ie on ESP32
+processors where FreeRTOS tasks can be pinned to a core. The class is not
+defined for other processors.
+*/
+#if defined(ARDUINO_ARCH_ESP32)
+#define OP_SERVICE 1
+#else
+#define OP_SERVICE 0
+#endif
+
+#if OP_SERVICE
+
+#ifndef OPSVC_QUEUE_SIZE
+#define OPSVC_QUEUE_SIZE 8      ///< request queue size, a power of 2. One less request than this can be queued.
+#endif
+
+#ifndef OPSVC_STACK_SIZE
+#define OPSVC_STACK_SIZE 3072   ///< service task stack size in bytes
+#endif
+
+/**
+ * Link service task for the MD_OnePin library (ESP32).
+ *
+ * The service runs all the transactions for a set of MD_OnePin links in a
+ * FreeRTOS task pinned to one core, so the blocking link timing never runs
+ * on the application core. The application submits write and read
+ * requests with submitWrite() and submitRead(), which return straight away.
+ *
+ * Requests are passed to the service through a lock-free single producer,
+ * single consumer queue of pointers to request_t structures owned by the
+ * application. Each request works as a future: the service fills in the
+ * result and then sets request_t::done, which the application can poll.
+ * A callback can also be given for each request, invoked by the service
+ * task just before done is set.
+ *
+ * Each transaction runs with the scheduler suspended on the service core,
+ * so no task switch (eg, FreeRTOS tick preemption) can stretch the signal
+ * timing part way through a packet. Interrupts are still taken, subject
+ * to OP_IRQ_MASK.
+ *
+ * Once the service has started, the links must only be used through the
+ * service. The requests need to be submitted from one task, and each
+ * request must stay in scope and not be changed until it is done.
+ *
+ * \sa \ref pageImplementation
+ */
+class MD_OnePinService
+{
+public:
+  struct request_t;
+
+  /**
+   * Request completion callback function.
+   *
+   * The callback is invoked from the service task when a request has
+   * completed, before request_t::done is set. As it delays other requests,
+   * the callback needs to be short.
+   *
+   * \param req the request that has completed.
+   */
+  typedef void (*cbRequest_t)(request_t *req);
+
+  /**
+   * A link request submitted to the service.
+   *
+   * \sa submitWrite(), submitRead()
+   */
+  struct request_t
+  {
+    uint8_t link;             ///< index of the link in the service link array
+    bool isRead;              ///< true for a read, false for a write
+    bool noReset;             ///< omit the Comms Reset signal
+    MD_OnePin::packet_t data; ///< data to write, or the data read when done
+    bool ok;                  ///< true if SEC was present (and CRC was ok) when done
+    volatile bool done;       ///< set by the service when the request has completed
+    cbRequest_t cb;           ///< completion callback, nullptr for none
+    void *user;               ///< application data for the callback
+  };
+
+  //--------------------------------------------------------------
+  /** \name Class constructor and destructor.
+   * @{
+   */
+  /**
+   * Class Constructor
+   *
+   * Instantiate a new instance of the class. The array of links supplied is
+   * not copied and needs to remain in scope for the life of the service.
+   *
+   * \param link  array of pointers to the MD_OnePin links served.
+   * \param count the number of links in the array.
+   */
+  MD_OnePinService(MD_OnePin *link[], uint8_t count) :
+    _link(link), _count(count), _task(nullptr), _head(0), _tail(0)
+    {};
+
+  /**
+   * Class Destructor.
+   *
+   * Release any allocated memory and clean up anything else.
+   */
+  ~MD_OnePinService() {};
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for core object control.
+   * @{
+   */
+  /**
+   * Start the service.
+   *
+   * Create the service task pinned to the core specified. The task
+   * initializes all the links with MD_OnePin::begin(), so the I/O
+   * calibration is also run on the service core, and then waits for
+   * requests.
+   *
+   * The service core is normally the one not running the Arduino loop()
+   * (ARDUINO_RUNNING_CORE), ie core 0 on dual core processors.
+   *
+   * \param core     the core the service task runs on.
+   * \param priority the FreeRTOS priority of the service task.
+   * \return true if the service task was created.
+   */
+  bool begin(BaseType_t core = 0, UBaseType_t priority = configMAX_PRIORITIES - 1);
+
+  /**
+   * Submit a PRI data packet write.
+   *
+   * Queue a request for the service to run MD_OnePin::write() on a link.
+   * The method returns straight away. When the request is done,
+   * request_t::ok is the value returned by write().
+   *
+   * \param req     the request, owned by the application until done.
+   * \param link    the index of the link in the link array.
+   * \param data    the data to sent to the SEC.
+   * \param noReset set true to omit the Comms Reset signal before sending data. Defaults to false (ie, reset).
+   * \param cb      the completion callback, nullptr (default) for none.
+   * \return true if the request was queued, false if the queue is full or the link is not valid.
+   */
+  bool submitWrite(request_t &req, uint8_t link, MD_OnePin::packet_t data, bool noReset = false, cbRequest_t cb = nullptr);
+
+  /**
+   * Submit a SEC data packet request.
+   *
+   * Queue a request for the service to run MD_OnePin::read() on a link.
+   * The method returns straight away. When the request is done,
+   * request_t::data is the value returned by read().
+   *
+   * \param req     the request, owned by the application until done.
+   * \param link    the index of the link in the link array.
+   * \param noReset set true to omit the Comms Reset signal before reading data. Defaults to false (ie, reset).
+   * \param cb      the completion callback, nullptr (default) for none.
+   * \return true if the request was queued, false if the queue is full or the link is not valid.
+   */
+  bool submitRead(request_t &req, uint8_t link, bool noReset = false, cbRequest_t cb = nullptr);
+
+  /**
+   * Check if a request has completed.
+   *
+   * \param req the request to check.
+   * \return true if the service has completed the request.
+   */
+  inline bool isDone(const request_t &req) { return(req.done); }
+
+  /**
+   * Get the number of requests waiting.
+   *
+   * \return the number of requests queued and not yet taken by the service.
+   */
+  inline uint8_t pending(void) { return((_head - _tail) & (OPSVC_QUEUE_SIZE - 1)); }
+
+  /** @} */
+
+private:
+  MD_OnePin **_link;      ///< the links served
+  uint8_t _count;         ///< the number of links
+  TaskHandle_t _task;     ///< the service task
+
+  // Lock-free single producer (application), single consumer (service) queue
+  request_t * volatile _queue[OPSVC_QUEUE_SIZE]; ///< requests waiting
+  volatile uint8_t _head; ///< next queue slot written by the application
+  volatile uint8_t _tail; ///< next queue slot read by the service
+
+  bool submit(request_t &req);      ///< queue a request
+  void serve(request_t &req);       ///< run one request
+  static void run(void *arg);       ///< service task body
+};
+#endif
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <MD_OnePin.h>
+
+#if defined(ARDUINO_ARCH_AVR)
+#include <util/delay.h>
+#endif
+
+/**
+ * \file
+ * \brief Header file and class template definition for the compile time MD_OnePin variant.
+ */
+
+/**
+ * Compile time bit counter used to unroll the MD_OnePinT bit loops.
+ */
+template <uint8_t N> struct opBitCount {};
+
+/**
+ * Compile time variant of the MD_OnePin object.
+ *
+ * The comms pin, the timeslot T and the packet sizes are all template
+ * parameters, so every protocol timing value is a compile time constant
+ * for each instance and the bit loops in write() and read() are fully
+ * unrolled. Different links with different T can coexist in the same PRI
+ * without changing the global OPT constant.
+ *
+ * Fast I/O is used when OP_FAST_IO is enabled and, on AVR, delays are
+ * generated cycle accurate using _delay_us(). No runtime calibration is
+ * done, so OP_FAST_IO should be enabled if T is small.
+ *
+ * Unrolling trades program memory for speed; every bit transferred has
+ * its own copy of the signaling code.
+ *
+ * \tparam PIN    pin used for OnePin comms.
+ * \tparam OPT_US the timeslot T in microseconds (default OPT).
+ * \tparam BPPPRI the number of bits per packet (bpp) sent by PRI.
+ * \tparam BPPSEC the number of bits per packet (bpp) received from SEC.
+ */
+template <uint8_t PIN, uint16_t OPT_US = OPT, uint8_t BPPPRI = BPP_PRI, uint8_t BPPSEC = BPP_SEC>
+class MD_OnePinT
+{
+  static_assert(BPPPRI > 0 && BPPPRI <= 32, "BPPPRI must be between 1 and 32");
+  static_assert(BPPSEC > 0 && BPPSEC <= 32, "BPPSEC must be between 1 and 32");
+  static_assert(OPT_US >= 2, "OPT_US is too small");
+
+public:
+  typedef opPriPacket_t packet_t;    ///< The Primary side comms packet. Defined as max size to fit all supported types.
+
+  //--------------------------------------------------------------
+  /** \name Link timing parameters for this instance.
+   * @{
+   */
+  static constexpr uint16_t T_RST_SIGNAL = OPT_RST_SIGNAL_T(OPT_US);         ///< OPT_RST_SIGNAL for this instance
+  static constexpr uint16_t T_RST_PRS_SAMPLE = OPT_RST_PRS_SAMPLE_T(OPT_US); ///< OPT_RST_PRS_SAMPLE for this instance
+  static constexpr uint16_t T_RST_END = OPT_RST_END_T(OPT_US);               ///< OPT_RST_END for this instance
+  static constexpr uint16_t T_WR1_SIGNAL = OPT_WR1_SIGNAL_T(OPT_US);         ///< OPT_WR1_SIGNAL for this instance
+  static constexpr uint16_t T_WR1_PAUSE = OPT_WR1_PAUSE_T(OPT_US);           ///< OPT_WR1_PAUSE for this instance
+  static constexpr uint16_t T_WR0_SIGNAL = OPT_WR0_SIGNAL_T(OPT_US);         ///< OPT_WR0_SIGNAL for this instance
+  static constexpr uint16_t T_WR0_PAUSE = OPT_WR0_PAUSE_T(OPT_US);           ///< OPT_WR0_PAUSE for this instance
+  static constexpr uint16_t T_RD_INIT = OPT_RD_INIT_T(OPT_US);               ///< OPT_RD_INIT for this instance
+  static constexpr uint16_t T_RD_SAMPLE = OPT_RD_SAMPLE_T(OPT_US);           ///< OPT_RD_SAMPLE for this instance
+  static constexpr uint16_t T_RD_PAUSE = OPT_RD_PAUSE_T(OPT_US);             ///< OPT_RD_PAUSE for this instance
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Class constructor.
+   * @{
+   */
+  /**
+   * Class Constructor
+   *
+   * Instantiate a new instance of the class template.
+   */
+  MD_OnePinT(void) : _presence(false)
+  {
+#if OP_FAST_IO
+    opIoInit(_io, PIN);
+#endif
+  };
+
+  /** @} */
+
+  //--------------------------------------------------------------
+  /** \name Methods for core object control.
+   * @{
+   */
+  /**
+   * Initialize the object.
+   *
+   * \sa MD_OnePin::begin()
+   */
+  void begin(void)
+  {
+    pinMode(PIN, INPUT_PULLUP);
+    setOutput();
+    setHigh();
+  }
+
+  /**
+   * Write a PRI data packet.
+   *
+   * \sa MD_OnePin::write()
+   *
+   * \param data    the data to sent to the SEC. Only BPPPRI bits will be transmitted.
+   * \param noReset set true to omit the Comms Reset signal before sending data. Defaults to false (ie, reset).
+   * \return true if the SEC device was present.
+   */
+  bool write(packet_t data, bool noReset = false)
+  {
+    if (!noReset) resetComm();
+    if (noReset || _presence) writeBits(data, opBitCount<BPPPRI>());
+
+    return(_presence);
+  }
+
+  /**
+   * Request a SEC data packet.
+   *
+   * \sa MD_OnePin::read()
+   *
+   * \param noReset set true to omit the Comms Reset signal before reading data. Defaults to false (ie, reset).
+   * \return Data packet received from the SEC. Only BPPSEC bits will be valid.
+   */
+  packet_t read(bool noReset = false)
+  {
+    if (!noReset) resetComm();
+    if (!noReset && !_presence) return(0xffffffff);
+
+    return(readBits(opBitCount<BPPSEC>()));
+  }
+
+  /**
+   * Secondary device presence status.
+   *
+   * \sa MD_OnePin::isPresent()
+   *
+   * \return true if the SEC was present at the last attempted comms.
+   */
+  inline bool isPresent(void) { return(_presence); }
+
+  /** @} */
+
+private:
+  bool _presence;     ///< result of the last presence check (true if present)
+
+#if OP_FAST_IO
+  opIo_t _io;         ///< cached fast I/O registers for PIN
+
+  inline __attribute__((always_inline)) void setInput(void)  { opIoClr(_io.dir, _io.mask); }
+  inline __attribute__((always_inline)) void setOutput(void) { opIoSet(_io.dir, _io.mask); }
+  inline __attribute__((always_inline)) void setHigh(void)   { opIoSet(_io.out, _io.mask); }
+  inline __attribute__((always_inline)) void setLow(void)    { opIoClr(_io.out, _io.mask); }
+  inline __attribute__((always_inline)) bool isHigh(void)    { return((*_io.in & _io.mask) != 0); }
+#else
+  inline __attribute__((always_inline)) void setInput(void)  { pinMode(PIN, INPUT_PULLUP); }
+  inline __attribute__((always_inline)) void setOutput(void) { pinMode(PIN, OUTPUT); }
+  inline __attribute__((always_inline)) void setHigh(void)   { digitalWrite(PIN, HIGH); }
+  inline __attribute__((always_inline)) void setLow(void)    { digitalWrite(PIN, LOW); }
+  inline __attribute__((always_inline)) bool isHigh(void)    { return(digitalRead(PIN) == HIGH); }
+#endif
+
+  // Delay for a compile time number of microseconds
+  template <uint16_t US> inline __attribute__((always_inline)) void wait(void)
+  {
+#if defined(ARDUINO_ARCH_AVR)
+    _delay_us(US);
+#else
+    delayMicroseconds(US);
+#endif
+  }
+
+  // Equivalent of the MD_OnePin OP_SIGNAL macro
+  template <uint16_t ACTIVE, uint16_t PAUSE> inline __attribute__((always_inline)) void signal(void)
+  {
+    opIrqState_t irq = opIrqSave();
+
+    setLow();
+    wait<ACTIVE>();
+    setHigh();
+    opIrqRestore(irq);
+    if (PAUSE != 0) wait<PAUSE>();
+  }
+
+  // Unrolled write of the N least significant bits of data, LSB first
+  template <uint8_t N> inline __attribute__((always_inline)) void writeBits(packet_t data, opBitCount<N>)
+  {
+    if (data & 1) signal<T_WR1_SIGNAL, T_WR1_PAUSE>();
+    else          signal<T_WR0_SIGNAL, T_WR0_PAUSE>();
+    writeBits(data >> 1, opBitCount<N - 1>());
+  }
+  inline void writeBits(packet_t, opBitCount<0>) {}
+
+  // Unrolled read of N bits, LSB first
+  template <uint8_t N> inline __attribute__((always_inline)) packet_t readBits(opBitCount<N>)
+  {
+    packet_t packet = readBits(opBitCount<N - 1>());
+    opIrqState_t irq = opIrqSave();
+
+    signal<T_RD_INIT, 0>();
+    setInput();
+    wait<T_RD_SAMPLE>();
+    if (isHigh()) packet |= ((packet_t)1 << (N - 1));
+    setOutput();
+    opIrqRestore(irq);
+    wait<T_RD_PAUSE>();
+
+    return(packet);
+  }
+  inline packet_t readBits(opBitCount<0>) { return(0); }
+
+  // Send a reset command and detect a presence response
+  bool resetComm(void)
+  {
+    opIrqState_t irq = opIrqSave();
+
+    setOutput();
+    signal<T_RST_SIGNAL, 0>();
+    setInput();
+    wait<T_RST_PRS_SAMPLE>();
+    _presence = !isHigh();
+    setOutput();
+    opIrqRestore(irq);
+    wait<T_RST_END>();
+
+    return(_presence);
+  }
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * \file
+ * \brief Header for the packet CRC-8 used by PRI and SEC.
+ *
+ * The CRC is the Dallas/Maxim 1-Wire CRC-8 (polynomial x^8 + x^5 + x^4 + 1,
+ * processed LSB first with an initial value of 0). It is worked out 4 bits
+ * at a time from two 16 entry tables to keep the flash used small.
+ *
+ * \sa \ref pageLinkSignals
+ */
+
+/**
+ * Add a byte to a CRC-8.
+ *
+ * \param crc  the CRC so far, 0 to start.
+ * \param data the next byte.
+ * \return the updated CRC.
+ */
+inline uint8_t opCrc8(uint8_t crc, uint8_t data)
+{
+  static const uint8_t PROGMEM crcLo[16] =
+  {
+    0x00, 0x5e, 0xbc, 0xe2, 0x61, 0x3f, 0xdd, 0x83,
+    0xc2, 0x9c, 0x7e, 0x20, 0xa3, 0xfd, 0x1f, 0x41
+  };
+  static const uint8_t PROGMEM crcHi[16] =
+  {
+    0x00, 0x9d, 0x23, 0xbe, 0x46, 0xdb, 0x65, 0xf8,
+    0x8c, 0x11, 0xaf, 0x32, 0xca, 0x57, 0xe9, 0x74
+  };
+
+  crc ^= data;
+  return(pgm_read_byte(&crcLo[crc & 0xf]) ^ pgm_read_byte(&crcHi[crc >> 4]));
+}
+
+/**
+ * Work out the CRC-8 for a packet.
+ *
+ * The CRC covers the bytes of the packet that hold data bits, LSB first.
+ * Unused bits in the last byte must be 0.
+ *
+ * \param data the packet data.
+ * \param bits the number of bits in the packet.
+ * \return the CRC for the packet.
+ */
+inline uint8_t opCrc8Packet(uint32_t data, uint8_t bits)
+{
+  uint8_t crc = 0;
+
+  for (uint8_t i = 0; i < bits; i += 8, data >>= 8)
+    crc = opCrc8(crc, data & 0xff);
+
+  return(crc);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * \file
+ * \brief Header for saving and restoring the interrupt state, used by PRI and SEC.
+ *
+ * Interrupts are masked and then put back the way they were, rather than
+ * just enabled, so code called with interrupts already off (eg, from
+ * another ISR or inside an application critical section) leaves them off.
+ */
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <hardware/sync.h>
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+typedef UBaseType_t opIrqState_t;   ///< saved interrupt state
+#else
+typedef uint32_t opIrqState_t;      ///< saved interrupt state
+#endif
+
+/**
+ * Save the interrupt state and mask interrupts.
+ *
+ * \return the interrupt state to pass to opIrqUnlock().
+ */
+inline __attribute__((always_inline)) opIrqState_t opIrqLock(void)
+{
+#if defined(ARDUINO_ARCH_AVR)
+  opIrqState_t s = SREG; cli(); return(s);
+#elif defined(ARDUINO_ARCH_ESP32)
+  return(portSET_INTERRUPT_MASK_FROM_ISR());  // this core only
+#elif defined(ARDUINO_ARCH_RP2040)
+  return(save_and_disable_interrupts());
+#elif defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+  opIrqState_t s = __get_PRIMASK(); __disable_irq(); return(s);
+#else
+  noInterrupts(); return(1);  // state unknown, assume enabled
+#endif
+}
+
+/**
+ * Restore the interrupt state saved by opIrqLock().
+ *
+ * \param s the interrupt state returned by opIrqLock().
+ */
+inline __attribute__((always_inline)) void opIrqUnlock(opIrqState_t s)
+{
+#if defined(ARDUINO_ARCH_AVR)
+  SREG = s;
+#elif defined(ARDUINO_ARCH_ESP32)
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(s);
+#elif defined(ARDUINO_ARCH_RP2040)
+  restore_interrupts(s);
+#elif defined(__ARM_ARCH_6M__) || defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+  __set_PRIMASK(s);
+#else
+  if (s) interrupts();
+#endif
+}
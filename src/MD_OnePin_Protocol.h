@@ -75,6 +75,138 @@ Note: The reset signal is the start of every transaction.
 -# On the PRI rising edge, SEC sets the link LOW for 1.5T to signal its presence.
 
 ![Reset/Presence Timing Diagram] (Reset_Presence.png "Reset/Presence Timing Diagram")
+
+## 2 Bit Write Symbols
+A link can optionally use 2 bit symbols for the data PRI writes to SEC. Each
+symbol sends 2 bits in one signal using 4 different signal lengths, cutting
+the time to write a 32 bit packet roughly in half. PRI and SEC must both be set
+up to use the same encoding. Reads and the other signals are not changed.
+-# PRI pulls the link LOW for 0.5T, T, 1.5T or 2T for symbol values 0 to 3 
+(the symbol value is the next 2 bits of the packet, LSB first).
+-# PRI sets the link HIGH for 0.5T before further signaling.
+-# SEC detection thresholds are halfway between the symbol lengths, with the 
+symbol 3 threshold halfway to the Read signal.
+-# If the packet has an odd number of bits, the last symbol only carries 1 bit.
+
+The smaller differences between the signal lengths need more accurate SEC 
+timing, such as a hardware timer (see MD_OnePin_SecTimer.h).
+
+## Write-Read Transaction
+A Read signal immediately after SEC has received a complete packet (with no
+Reset in between) is a turnaround slot rather than a data bit.
+-# SEC pulls the link LOW in the turnaround slot while it is busy working out
+the reply to the packet received.
+-# PRI repeats the turnaround slot until the link is HIGH (SEC is ready) or a 
+set number of slots have been sent.
+-# The following Read signals read the reply packet as for a normal read.
+
+This allows a command to be sent and its reply read in one transaction.
+
+## Length-Prefixed Frames
+A frame moves a block of up to 255 bytes in one transaction, for data 
+that does not fit in a packet. The frame replaces the packets after the 
+Reset/Presence signal.
+-# PRI pulls the link LOW for 4T (Frame signal) and then sets it HIGH.
+-# SEC that supports frames leaves the link HIGH. PRI reads the link T after 
+the rising edge, as for a Reset, and a LOW means SEC has seen a Reset signal 
+instead, so it does not support frames. PRI then waits 1.5T.
+-# For a frame written by PRI, PRI sends a length byte followed by that many 
+data bytes, all LSB first using the Write signals (or 2 bit symbols).
+-# For a frame read by PRI, PRI uses Read signals to get the length byte and 
+then that many data bytes from SEC.
+-# If CRC checking is used, the CRC-8 of the length and data bytes follows the
+data. For a write, SEC then ACKs or NAKs the frame in a Read slot as for a 
+packet. Frames are not retried.
+
+SEC detects signals longer than 3T and up to 4.5T as a Frame signal. Longer 
+signals are Reset signals. The frame ends the transaction; the next 
+transaction starts with a Reset.
+
+## Attention Signal
+A SEC can ask PRI to start communications using an Attention signal, so that
+PRI does not need to keep polling SEC for new data. PRI must be set up to 
+leave the link as an input (pulled HIGH) between transactions, as SEC drives
+the link while it is idle.
+-# SEC waits until the link has been idle (HIGH with no signals) for 4T.
+-# SEC pulls the link LOW for 2T and then releases it.
+-# PRI detects the LOW on the idle link using a pin change interrupt, or by 
+checking the link before it starts the next transaction, and marks the link 
+as needing attention. PRI then starts a transaction as normal to find out 
+what SEC wants.
+
+The SEC signal decoding is not changed by an Attention signal, so it can be 
+sent between any PRI transactions. If SEC and PRI start signaling at the same
+time the PRI transaction fails as SEC misses the start of the Reset, and 
+needs to be retried.
+
+## Packet CRC
+A link can optionally add an 8 bit CRC (Dallas/Maxim 1-Wire CRC-8, see 
+MD_OnePin_Crc.h) to each packet so that corrupted bits are detected. PRI 
+and SEC must both be set up to use it.
+-# For a write, PRI sends the packet bits followed by the 8 CRC bits, LSB 
+first, and then a Read signal for the ACK slot. SEC pulls the link LOW in 
+the ACK slot (ie, sends a 0) if the CRC is correct and leaves it HIGH (NAK) 
+if it is not. A NAKed packet is discarded by SEC.
+-# For a read, SEC sends the packet bits followed by the 8 CRC bits, and PRI 
+then sends a Write 1 (ACK) if the CRC is correct or Write 0 (NAK) if it is 
+not. After a NAK, SEC sends the same packet again for the next read.
+-# After a NAK PRI immediately sends or reads the packet again, without a 
+Reset, up to a set number of retries.
+-# With 2 bit write symbols the CRC and PRI ACK/NAK are sent as symbols,
+the ACK/NAK as a 1 bit symbol.
+
+## Register Access
+SEC devices often expose a small set of registers (eg, rate, mode, counters)
+rather than a stream of data. The register protocol puts a command and a 
+register number in the top bits of a normal PRI packet, so it uses the same
+signals as any other packet.
+-# The top OPR_OP_BITS bits of the PRI packet are the operation and the next 
+OPR_REG_BITS bits the register number. The remaining low bits are the value 
+for a write or the number of registers for a burst read.
+-# A register write is a normal write of the command packet.
+-# A register read is a write-read transaction. The reply is the register 
+value as a SEC packet.
+-# A burst read is a write-read transaction for the first register, followed
+straight away (with no Reset) by Read signals for the following registers, 
+one SEC packet each.
+
+Unknown registers read as all 1 bits and writes to them are ignored. The PRI
+packet needs to be at least OPR_OP_BITS + OPR_REG_BITS bits.
+
+## Changing the Timeslot
+T is normally fixed at the default OPT in both PRI and SEC. SEC devices that
+support it can have T changed at run time by PRI.
+
+### Sync Signal
+The Sync signal is always sent using the default timeslot OPT, whatever the 
+current T, so that it is recognized by SEC at any T.
+-# PRI sets the link LOW for 7 OPT and then sets it HIGH.
+-# SEC detects any signal longer than 6 OPT as a Sync and signals its presence
+as for a Reset signal, but using the default timeslot OPT.
+-# The next signal from PRI is a Reset signal using the new T. SEC measures 
+its length to work out the new T (length/5), and signals its presence using 
+the new T. If the new T is too small for SEC it does not signal its presence
+and keeps the previous T, and so does PRI.
+
+The Reset signal at the new T must be shorter than the Sync detection time,
+so T can be at most OPT_MAX, the largest T with 5T less than 6 OPT. PRI 
+does not send a Sync for a T outside OPT_MIN to OPT_MAX.
+
+Legacy SEC see the Sync signal as a normal Reset signal.
+
+### Test Frame
+The transaction started by the Reset signal after a Sync is a test frame. In
+a test frame, a Read returns the last packet written by PRI, and SEC is never
+busy in a write-read transaction. PRI uses test 
+frames to check that a new T works reliably with known data patterns. The 
+test frame ends at the next Reset or Sync signal.
+
+### Overdrive
+Overdrive is a timeslot change to the high speed timeslot OPT_OD (about 
+10&micro;s) for bulk transfers with SEC that are fast enough to support it. 
+It uses the same Sync and Reset signals as any other timeslot change. As 
+the Sync signal is always sent using OPT, PRI can always return a SEC to 
+the default timeslot, even if signals at the overdrive T are failing.
 */
 
 /**
@@ -127,29 +259,112 @@ typedef uint32_t opSecPacket_t;
 #error opSecPacket_t size not properly defined
 #endif
 
+// Register access command packet fields, see "Register Access" in \ref pageLinkSignals.
+#define OPR_OP_BITS   2   ///< register command operation bits, the top bits of the PRI packet
+#define OPR_REG_BITS  6   ///< register number bits, below the operation bits
+
+#define OPR_WRITE 0       ///< register command, write the value to the register
+#define OPR_READ  1       ///< register command, read the register
+#define OPR_READN 2       ///< register command, burst read value registers starting at the register
+
+#define OPR_VALUE_BITS(bpp) ((bpp) - OPR_OP_BITS - OPR_REG_BITS)  ///< value bits in a register command packet of bpp bits
+#define OPR_VALUE_MASK(bpp) (((opPriPacket_t)1 << OPR_VALUE_BITS(bpp)) - 1) ///< mask for the value bits of a register command
+
+/// Register command packet of bpp bits for operation op, register reg and value v
+#define OPR_CMD(bpp, op, reg, v) \
+  (((opPriPacket_t)(op) << ((bpp) - OPR_OP_BITS)) | ((opPriPacket_t)(reg) << OPR_VALUE_BITS(bpp)) | ((opPriPacket_t)(v) & OPR_VALUE_MASK(bpp)))
+
+#define OPR_CMD_OP(bpp, c)    (((c) >> ((bpp) - OPR_OP_BITS)) & ((1 << OPR_OP_BITS) - 1))  ///< operation of a register command packet
+#define OPR_CMD_REG(bpp, c)   (((c) >> OPR_VALUE_BITS(bpp)) & ((1 << OPR_REG_BITS) - 1))   ///< register number of a register command packet
+#define OPR_CMD_VALUE(bpp, c) ((c) & OPR_VALUE_MASK(bpp))                                 ///< value of a register command packet
+
+// One Wire timing relationships in microseconds for a timeslot of t microseconds.
+// The OPT_* constants below are these values for the default timeslot OPT.
+
+//-- Reset
+#define OPT_RST_SIGNAL_T(t)     (5 * (t))                       ///< OPT_RST_SIGNAL for timeslot t
+#define OPT_RST_PRESENCE_T(t)   ((3 * (t)) / 2)                 ///< OPT_RST_PRESENCE for timeslot t
+#define OPT_RST_PRS_SAMPLE_T(t) (t)                             ///< OPT_RST_PRS_SAMPLE for timeslot t
+#define OPT_RST_END_T(t)        ((3 * (t)) / 2)                 ///< OPT_RST_END for timeslot t
+
+//-- Write 1
+#define OPT_WR1_SIGNAL_T(t)     ((t) / 2)                       ///< OPT_WR1_SIGNAL for timeslot t
+#define OPT_WR1_PAUSE_T(t)      ((t) - OPT_WR1_SIGNAL_T(t))     ///< OPT_WR1_PAUSE for timeslot t
+#define OPT_WR1_DETECT_T(t)     (t)                             ///< OPT_WR1_DETECT for timeslot t
+
+//-- Write 0
+#define OPT_WR0_SIGNAL_T(t)     ((3 * (t)) / 2)                 ///< OPT_WR0_SIGNAL for timeslot t
+#define OPT_WR0_DETECT_T(t)     (2 * (t))                       ///< OPT_WR0_DETECT for timeslot t
+#define OPT_WR0_PAUSE_T(t)      ((2 * (t)) - OPT_WR0_SIGNAL_T(t)) ///< OPT_WR0_PAUSE for timeslot t
+
+//-- 2 bit write symbols
+#define OPT_SYM_SIGNAL_T(t, s)  ((((s) + 1) * (t)) / 2)         ///< OPT_SYMn_SIGNAL for timeslot t and symbol s
+#define OPT_SYM_DETECT_T(t, s)  ((((2 * (s)) + 3) * (t)) / 4)   ///< OPT_SYMn_DETECT for timeslot t and symbol s
+#define OPT_SYM_PAUSE_T(t)      ((t) / 2)                       ///< OPT_SYM_PAUSE for timeslot t
+
+//-- Read
+#define OPT_RD_INIT_T(t)        ((5 * (t)) / 2)                 ///< OPT_RD_INIT for timeslot t
+#define OPT_RD_DETECT_T(t)      (3 * (t))                       ///< OPT_RD_DETECT for timeslot t
+#define OPT_RD0_SIGNAL_T(t)     (t)                             ///< OPT_RD0_SIGNAL for timeslot t
+#define OPT_RD_SAMPLE_T(t)      (OPT_RD0_SIGNAL_T(t) / 2)       ///< OPT_RD_SAMPLE for timeslot t
+#define OPT_RD_PAUSE_T(t)       (t)                             ///< OPT_RD_PAUSE for timeslot t
+
+//-- Frame
+#define OPT_FRM_SIGNAL_T(t)     (4 * (t))                       ///< OPT_FRM_SIGNAL for timeslot t
+#define OPT_FRM_DETECT_T(t)     ((9 * (t)) / 2)                 ///< OPT_FRM_DETECT for timeslot t
+
+//-- Attention
+#define OPT_ATN_SIGNAL_T(t)     (2 * (t))                       ///< OPT_ATN_SIGNAL for timeslot t
+#define OPT_ATN_IDLE_T(t)       (4 * (t))                       ///< OPT_ATN_IDLE for timeslot t
+
 // One Wire timing values in microseconds
 const uint16_t OPT = 80;     ///< OnePin Timesleot in microseconds - all timing is multiples/fractions of this
 
 //-- Reset
-const uint16_t OPT_RST_SIGNAL = 5 * OPT;                  ///< Reset the device for a new command
-const uint16_t OPT_RST_PRESENCE = (3 * OPT) / 2;          ///< Duration of SEC presence signal
-const uint16_t OPT_RST_PRS_SAMPLE = OPT;                  ///< PRI presence sampling time after setting rising edge
-const uint16_t OPT_RST_END = (3 * OPT) / 2;               ///< Delay presence sampling before the next comms
+const uint16_t OPT_RST_SIGNAL = OPT_RST_SIGNAL_T(OPT);          ///< Reset the device for a new command
+const uint16_t OPT_RST_PRESENCE = OPT_RST_PRESENCE_T(OPT);      ///< Duration of SEC presence signal
+const uint16_t OPT_RST_PRS_SAMPLE = OPT_RST_PRS_SAMPLE_T(OPT);  ///< PRI presence sampling time after setting rising edge
+const uint16_t OPT_RST_END = OPT_RST_END_T(OPT);                ///< Delay presence sampling before the next comms
 
 //-- Write 1
-const uint16_t OPT_WR1_SIGNAL = OPT / 2;                  ///< Write a 1 line active time (low signal)
-const uint16_t OPT_WR1_PAUSE = OPT - OPT_WR1_SIGNAL;      ///< Write a 1 line delay time (high signal after active)
-const uint16_t OPT_WR1_DETECT = OPT;                      ///< Write a 1 SEC read detection threshold
+const uint16_t OPT_WR1_SIGNAL = OPT_WR1_SIGNAL_T(OPT);          ///< Write a 1 line active time (low signal)
+const uint16_t OPT_WR1_PAUSE = OPT_WR1_PAUSE_T(OPT);            ///< Write a 1 line delay time (high signal after active)
+const uint16_t OPT_WR1_DETECT = OPT_WR1_DETECT_T(OPT);          ///< Write a 1 SEC read detection threshold
 
 //-- Write 0
-const uint16_t OPT_WR0_SIGNAL = (3 * OPT) / 2;            ///< Write a 0 line active time (low signal)
-const uint16_t OPT_WR0_DETECT = 2 * OPT;                  ///< Write a 0 SEC read detection threshold
-const uint16_t OPT_WR0_PAUSE = (2 * OPT) - OPT_WR0_SIGNAL;///< Write a 0 line delay time (high signal after active)
+const uint16_t OPT_WR0_SIGNAL = OPT_WR0_SIGNAL_T(OPT);          ///< Write a 0 line active time (low signal)
+const uint16_t OPT_WR0_DETECT = OPT_WR0_DETECT_T(OPT);          ///< Write a 0 SEC read detection threshold
+const uint16_t OPT_WR0_PAUSE = OPT_WR0_PAUSE_T(OPT);            ///< Write a 0 line delay time (high signal after active)
+
+//-- 2 bit write symbols
+const uint16_t OPT_SYM0_SIGNAL = OPT_SYM_SIGNAL_T(OPT, 0);      ///< Write symbol 0 (bits 00) line active time
+const uint16_t OPT_SYM1_SIGNAL = OPT_SYM_SIGNAL_T(OPT, 1);      ///< Write symbol 1 (bits 01) line active time
+const uint16_t OPT_SYM2_SIGNAL = OPT_SYM_SIGNAL_T(OPT, 2);      ///< Write symbol 2 (bits 10) line active time
+const uint16_t OPT_SYM3_SIGNAL = OPT_SYM_SIGNAL_T(OPT, 3);      ///< Write symbol 3 (bits 11) line active time
+const uint16_t OPT_SYM0_DETECT = OPT_SYM_DETECT_T(OPT, 0);      ///< Write symbol 0 SEC detection threshold
+const uint16_t OPT_SYM1_DETECT = OPT_SYM_DETECT_T(OPT, 1);      ///< Write symbol 1 SEC detection threshold
+const uint16_t OPT_SYM2_DETECT = OPT_SYM_DETECT_T(OPT, 2);      ///< Write symbol 2 SEC detection threshold
+const uint16_t OPT_SYM3_DETECT = OPT_SYM_DETECT_T(OPT, 3);      ///< Write symbol 3 SEC detection threshold
+const uint16_t OPT_SYM_PAUSE = OPT_SYM_PAUSE_T(OPT);            ///< Write symbol line delay time (high signal after active)
 
 //-- Read
-const uint16_t OPT_RD_INIT = (5 * OPT) / 2;               ///< Read activation signal
-const uint16_t OPT_RD_DETECT = 3 * OPT;                   ///< Read bit SEC detection threshold
-const uint16_t OPT_RD0_SIGNAL = OPT;                      ///< SEC hold time to signal a 0
-const uint16_t OPT_RD_SAMPLE = OPT_RD0_SIGNAL / 2;        ///< PRI read signal sampling time after read signal
-const uint16_t OPT_RD_PAUSE = OPT;                        ///< PRI read pause before next read
+const uint16_t OPT_RD_INIT = OPT_RD_INIT_T(OPT);                ///< Read activation signal
+const uint16_t OPT_RD_DETECT = OPT_RD_DETECT_T(OPT);            ///< Read bit SEC detection threshold
+const uint16_t OPT_RD0_SIGNAL = OPT_RD0_SIGNAL_T(OPT);          ///< SEC hold time to signal a 0
+const uint16_t OPT_RD_SAMPLE = OPT_RD_SAMPLE_T(OPT);            ///< PRI read signal sampling time after read signal
+const uint16_t OPT_RD_PAUSE = OPT_RD_PAUSE_T(OPT);              ///< PRI read pause before next read
+
+//-- Sync (always at the default timeslot OPT)
+const uint16_t OPT_SYNC_SIGNAL = 7 * OPT;                       ///< PRI sync signal to change the timeslot
+const uint16_t OPT_SYNC_DETECT = 6 * OPT;                       ///< Sync SEC detection threshold
+const uint16_t OPT_MIN = OPT / 8;                               ///< Smallest timeslot tried when PRI negotiates T
+const uint16_t OPT_MAX = (OPT_SYNC_DETECT - 1) / OPT_RST_SIGNAL_T(1); ///< Largest timeslot, with the Reset signal shorter than a Sync
+const uint16_t OPT_OD = 10;                                     ///< Overdrive (high speed) timeslot in microseconds
+
+//-- Frame
+const uint16_t OPT_FRM_SIGNAL = OPT_FRM_SIGNAL_T(OPT);          ///< PRI frame start signal line active time (low signal)
+const uint16_t OPT_FRM_DETECT = OPT_FRM_DETECT_T(OPT);          ///< Frame SEC detection threshold, longer signals are Reset
 
+//-- Attention
+const uint16_t OPT_ATN_SIGNAL = OPT_ATN_SIGNAL_T(OPT);          ///< SEC attention signal line active time (low signal)
+const uint16_t OPT_ATN_IDLE = OPT_ATN_IDLE_T(OPT);              ///< Idle link time before SEC can send an attention signal
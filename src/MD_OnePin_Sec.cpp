@@ -0,0 +1,815 @@
+#include <MD_OnePin_Sec.h>
+
+/**
+ * \file
+ * \brief Code file for the packaged SEC implementation of the OnePin protocol.
+ */
+
+#if (OPS_RX_QUEUE_SIZE & (OPS_RX_QUEUE_SIZE - 1)) != 0
+#error OPS_RX_QUEUE_SIZE must be a power of 2
+#endif
+#if (OPS_TX_QUEUE_SIZE & (OPS_TX_QUEUE_SIZE - 1)) != 0
+#error OPS_TX_QUEUE_SIZE must be a power of 2
+#endif
+#if OPS_TRACE && ((OPS_TRACE_SIZE & (OPS_TRACE_SIZE - 1)) != 0 || OPS_TRACE_SIZE > 128)
+#error OPS_TRACE_SIZE must be a power of 2 no more than 128
+#endif
+
+// ---- Macros for local inline code (time critical sections)
+#define SET_TO_INPUT  pinMode(secPin, INPUT_PULLUP)
+#define SET_TO_OUTPUT pinMode(secPin, OUTPUT)
+
+/// Pull the link LOW for the specified time in microseconds, then release it
+#define SEC_SIGNAL_LOW(us) do { SET_TO_OUTPUT; digitalWrite(secPin, LOW); delayMicroseconds(us); SET_TO_INPUT; } while (false)
+
+// ---- Link configuration
+static uint8_t secPin;          ///< the comms pin
+
+// ---- Link timing, follows the timeslot T set by PRI using a Sync signal
+static uint16_t timeSlot = OPT;   ///< current timeslot T
+static opsTick_t tickWr1Detect = OPS_US_TO_TICKS(OPT_WR1_DETECT);
+static opsTick_t tickWr0Detect = OPS_US_TO_TICKS(OPT_WR0_DETECT);
+static opsTick_t tickRdDetect = OPS_US_TO_TICKS(OPT_RD_DETECT);
+#if OPS_FRAMES
+static opsTick_t tickFrmDetect = OPS_US_TO_TICKS(OPT_FRM_DETECT);
+#endif
+#if OPS_WRITE_2BIT
+static opsTick_t tickSymDetect[4] = 
+{ 
+  OPS_US_TO_TICKS(OPT_SYM0_DETECT), OPS_US_TO_TICKS(OPT_SYM1_DETECT), 
+  OPS_US_TO_TICKS(OPT_SYM2_DETECT), OPS_US_TO_TICKS(OPT_SYM3_DETECT) 
+};
+#endif
+static uint16_t timePresence = OPT_RST_PRESENCE;
+static uint16_t timeRdSignal = OPT_RD0_SIGNAL;
+static uint16_t timeAtnSignal = OPT_ATN_SIGNAL;
+static opsTick_t tickAtnIdle = OPS_US_TO_TICKS(OPT_ATN_IDLE);
+static volatile opsTick_t tickLastEdge = 0;   ///< time of the last link edge, set by the ISR
+static volatile uint32_t msLastEdge = 0;      ///< millis() at the last link edge, for quiet times longer than the timer wraps
+
+static_assert(OPT_ATN_IDLE_T(OPT_MAX) < 1000, "The attention idle time must be less than 1ms");
+
+// ---- Packet data shared ISR/main code
+// The packet queues are single producer/single consumer rings. Only the
+// producer writes the head index and only the consumer writes the tail
+// index, and each is a single byte, so the ISR and main code can share
+// them without disabling interrupts. The data is written into the slot
+// before the head index is moved, so the consumer never sees a slot
+// before it is complete. One slot is always left empty to tell a full
+// queue from an empty one.
+static volatile opPriPacket_t rxQueue[OPS_RX_QUEUE_SIZE]; ///< packets received, written by the ISR
+static volatile uint8_t rxHead = 0;   ///< next rx slot written by the ISR
+static volatile uint8_t rxTail = 0;   ///< next rx slot read by the main code
+static volatile uint8_t rxLost = 0;   ///< rx packets lost because the queue was full
+
+static volatile opSecPacket_t txQueue[OPS_TX_QUEUE_SIZE]; ///< replies queued by the main code
+static volatile uint8_t txHead = 0;   ///< next tx slot written by the main code
+static volatile uint8_t txTail = 0;   ///< next tx slot read by the ISR
+static opSecPacket_t txLast = 0;      ///< last reply sent, repeated when the tx queue is empty
+static opSecPacket_t txNext = 0;      ///< queued reply pre-fetched for the next packet sent
+static bool txNextReady = false;      ///< txNext holds the next packet to send
+
+static volatile opSecPacket_t replyNext = 0;  ///< reply set by opsSetReply()
+static volatile bool replyNew = false;        ///< replyNext changed since it was last sent
+static volatile bool replyBusy = false;       ///< waiting for the application reply to a command
+static opsCommand_t cmdHandler = nullptr;     ///< application command handler run in the ISR
+
+#if OPS_REGS
+static const opsRegister_t *regTable = nullptr; ///< register table
+static uint8_t regCount = 0;                  ///< number of registers in the table
+static uint8_t regNext = 0;                   ///< next register sent to PRI
+static uint8_t regLeft = 0;                   ///< registers still to send in this transaction
+#endif
+
+#if OPS_FRAMES
+// ---- Frame data shared ISR/main code
+// The rx frame buffer belongs to the ISR until a frame is complete and 
+// then to the main code until it calls opsFrameDone().
+static uint8_t *rxFrameBuf = nullptr;         ///< buffer for received frames
+static uint8_t rxFrameSize = 0;               ///< size of the rx frame buffer
+static volatile uint8_t rxFrameLen = 0;       ///< length of the frame in the buffer
+static volatile bool rxFrameReady = false;    ///< a received frame is waiting in the buffer
+static const uint8_t *txFrameBuf = nullptr;   ///< frame sent to PRI
+static uint8_t txFrameLen = 0;                ///< length of the frame sent to PRI
+#endif
+
+#if OPS_TRACE
+// ---- Signal trace, written by the ISR
+// The oldest record is overwritten when the ring is full, so reading
+// is done with interrupts disabled.
+static opTrace_t traceRing[OPS_TRACE_SIZE]; ///< signal trace ring
+static uint8_t traceHead = 0;             ///< next record written
+static volatile uint8_t traceCount = 0;   ///< number of records held
+
+static void traceAdd(uint8_t type, opsTick_t low, opsTick_t high)
+{
+  opTrace_t &rec = traceRing[traceHead];
+
+  rec.type = type;
+  rec.low = opTraceTime(OPS_TICKS_TO_US(low));
+  rec.high = opTraceTime(OPS_TICKS_TO_US(high));
+  traceHead = (traceHead + 1) & (OPS_TRACE_SIZE - 1);
+  if (traceCount < OPS_TRACE_SIZE) traceCount = traceCount + 1;
+}
+
+#define TRACE_SIGNAL(type) traceAdd(type, duration, gap)
+#else
+#define TRACE_SIGNAL(type) do {} while (false)
+#endif
+
+static void setTimeslot(uint16_t t)
+{
+  timeSlot = t;
+  tickWr1Detect = OPS_US_TO_TICKS(OPT_WR1_DETECT_T(t));
+  tickWr0Detect = OPS_US_TO_TICKS(OPT_WR0_DETECT_T(t));
+  tickRdDetect = OPS_US_TO_TICKS(OPT_RD_DETECT_T(t));
+#if OPS_FRAMES
+  tickFrmDetect = OPS_US_TO_TICKS(OPT_FRM_DETECT_T(t));
+#endif
+#if OPS_WRITE_2BIT
+  for (uint8_t i = 0; i < 4; i++)
+    tickSymDetect[i] = OPS_US_TO_TICKS(OPT_SYM_DETECT_T(t, i));
+#endif
+  timePresence = OPT_RST_PRESENCE_T(t);
+  timeRdSignal = OPT_RD0_SIGNAL_T(t);
+  timeAtnSignal = OPT_ATN_SIGNAL_T(t);
+  tickAtnIdle = OPS_US_TO_TICKS(OPT_ATN_IDLE_T(t));
+}
+
+static void rxPush(opPriPacket_t data)
+{
+  uint8_t next = (rxHead + 1) & (OPS_RX_QUEUE_SIZE - 1);
+
+  if (next == rxTail)     // full, the packet is lost
+  {
+    if (rxLost != 0xff) rxLost++;
+  }
+  else
+  {
+    rxQueue[rxHead] = data;
+    rxHead = next;
+  }
+}
+
+static opSecPacket_t txPop(void)
+// Next packet to send. Queued replies are sent in order. When 
+// the queue is empty the last opsSetReply() data is sent.
+{
+  if (txHead != txTail)
+  {
+    txLast = txQueue[txTail];
+    txTail = (txTail + 1) & (OPS_TX_QUEUE_SIZE - 1);
+  }
+  else if (replyNew)
+  {
+    txLast = replyNext;
+    replyNew = false;
+  }
+
+  return(txLast);
+}
+
+static void txPrefetch(void)
+// Move the next queued reply into the send register while the link 
+// is idle, so that starting the next packet only has to send a bit.
+{
+  if (!txNextReady && txHead != txTail)
+  {
+    txNext = txQueue[txTail];
+    if (OPS_BPP_SEC < 32) txNext &= (((opSecPacket_t)1 << OPS_BPP_SEC) - 1);
+    txTail = (txTail + 1) & (OPS_TX_QUEUE_SIZE - 1);
+    txNextReady = true;
+  }
+}
+
+void opsBegin(uint8_t pin, bool attachISR)
+{
+  secPin = pin;
+  SET_TO_INPUT;
+  OPS_TIMER_BEGIN();
+  if (attachISR)
+    attachInterrupt(digitalPinToInterrupt(secPin), opsISR, CHANGE);
+}
+
+bool opsAvailable(void)
+{
+  return(rxHead != rxTail);
+}
+
+opPriPacket_t opsRead(void)
+{
+  opPriPacket_t data = 0;
+
+  if (rxHead != rxTail)
+  {
+    data = rxQueue[rxTail];
+    rxTail = (rxTail + 1) & (OPS_RX_QUEUE_SIZE - 1);
+  }
+
+  return(data);
+}
+
+uint8_t opsRxLost(void)
+{
+  uint8_t n;
+  opIrqState_t irq = opIrqLock();
+
+  n = rxLost;
+  rxLost = 0;
+  opIrqUnlock(irq);
+
+  return(n);
+}
+
+void opsSetReply(opSecPacket_t data)
+{
+  opIrqState_t irq = opIrqLock();   // multi byte value is also read by the ISR
+
+  replyNext = data;
+  replyNew = true;
+  replyBusy = false;
+  opIrqUnlock(irq);
+}
+
+bool opsQueueReply(opSecPacket_t data)
+{
+  uint8_t next = (txHead + 1) & (OPS_TX_QUEUE_SIZE - 1);
+
+  if (next == txTail) return(false);    // full
+
+  txQueue[txHead] = data;
+  txHead = next;
+  replyBusy = false;
+
+  return(true);
+}
+
+void opsSetCommandHandler(opsCommand_t cb)
+{
+  cmdHandler = cb;
+}
+
+#if OPS_REGS
+void opsSetRegisters(const opsRegister_t *table, uint8_t count)
+{
+  opIrqState_t irq = opIrqLock();
+
+  regTable = table;
+  regCount = (table == nullptr) ? 0 : count;
+  regLeft = 0;
+  opIrqUnlock(irq);
+}
+#endif
+
+#if OPS_FRAMES
+void opsSetRxFrame(uint8_t *buf, uint8_t size)
+{
+  opIrqState_t irq = opIrqLock();
+
+  rxFrameBuf = buf;
+  rxFrameSize = (buf == nullptr) ? 0 : size;
+  rxFrameReady = false;
+  opIrqUnlock(irq);
+}
+
+bool opsFrameAvailable(void)
+{
+  return(rxFrameReady);
+}
+
+uint8_t opsFrameLength(void)
+{
+  return(rxFrameLen);
+}
+
+void opsFrameDone(void)
+{
+  rxFrameReady = false;
+}
+
+void opsSetTxFrame(const uint8_t *buf, uint8_t len)
+{
+  opIrqState_t irq = opIrqLock();   // latched by the ISR at the start of a frame read
+
+  txFrameBuf = buf;
+  txFrameLen = (buf == nullptr) ? 0 : len;
+  opIrqUnlock(irq);
+}
+#endif
+
+bool opsAttention(void)
+{
+  bool sent = false;
+  opIrqState_t irq;
+
+  // The link must be HIGH and quiet for longer than any gap in a PRI 
+  // transaction. Interrupts stay off so the check and signal are not split,
+  // and the edges caused by the signal are ignored by the ISR afterwards.
+  // The timer can wrap in a long quiet time (32ms for Timer1), so more than
+  // 1ms by millis() is always quiet and the timer is only used below that.
+  irq = opIrqLock();
+  if (digitalRead(secPin) == HIGH && 
+      (millis() - msLastEdge > 1 || (opsTick_t)(OPS_TIMER_NOW() - tickLastEdge) > tickAtnIdle))
+  {
+    SEC_SIGNAL_LOW(timeAtnSignal);
+    tickLastEdge = OPS_TIMER_NOW();
+    msLastEdge = millis();
+    sent = true;
+  }
+  opIrqUnlock(irq);
+
+  return(sent);
+}
+
+uint16_t opsGetTimeslot(void)
+{
+  return(timeSlot);
+}
+
+#if OPS_TRACE
+uint8_t opsTraceAvailable(void)
+{
+  return(traceCount);
+}
+
+bool opsTraceRead(opTrace_t &rec)
+{
+  bool found = false;
+  opIrqState_t irq = opIrqLock();
+
+  if (traceCount != 0)
+  {
+    rec = traceRing[(traceHead - traceCount) & (OPS_TRACE_SIZE - 1)];
+    traceCount = traceCount - 1;
+    found = true;
+  }
+  opIrqUnlock(irq);
+
+  return(found);
+}
+
+void opsTraceClear(void)
+{
+  traceCount = 0;
+}
+#endif
+
+// ---- Packet state, only used by the ISR
+static opPriPacket_t rxData = 0;  ///< packet being received
+static opPriPacket_t rxLast = 0;  ///< last complete packet received
+static uint8_t rxBit = 0;         ///< next bit received, including CRC bits
+static opSecPacket_t txData = 0;  ///< packet being sent
+static uint8_t txBit = 0;         ///< next bit sent, including CRC bits
+static bool syncRcv = false;      ///< Sync received, next signal is the Reset at the new T
+static bool testFrame = false;    ///< in a test frame, reads return the last packet received
+static bool turnaround = false;   ///< a Read now is the turnaround slot for a write-read transaction
+
+#if OPS_CRC
+static uint8_t rxCrc = 0;         ///< CRC received from PRI
+static uint8_t txCrc = 0;         ///< CRC for the packet being sent
+static bool rxAckSlot = false;    ///< next Read is the ACK slot for the packet received
+static bool rxAck = false;        ///< the packet received had a good CRC
+static bool txAckWait = false;    ///< next Write is the PRI ACK for the packet sent
+static bool txRepeat = false;     ///< PRI NAKed the packet sent, so send it again
+#define RX_BITS (OPS_BPP_PRI + 8) ///< bits received for a packet
+#define TX_BITS (OPS_BPP_SEC + 8) ///< bits sent for a packet
+#else
+#define RX_BITS OPS_BPP_PRI
+#define TX_BITS OPS_BPP_SEC
+#endif
+
+#if OPS_FRAMES
+/// Frame transaction steps
+enum frameState_t : uint8_t
+{
+  FS_NONE,    // no frame, signals are packet bits
+  FS_START,   // Frame signal received, the next signal sets the direction
+  FS_RX,      // receiving a frame from PRI
+  FS_RX_ACK,  // next Read is the ACK slot for the frame received
+  FS_TX,      // sending a frame to PRI
+  FS_END,     // frame complete, ignore signals until the next Reset
+};
+
+static uint8_t frmState = FS_NONE;  ///< current frame step
+static uint8_t frmLen = 0;          ///< frame length in bytes
+static uint16_t frmIdx = 0;         ///< current byte, 0 is the length and frmLen+1 the CRC
+static uint8_t frmByte = 0;         ///< byte being sent or received
+static uint8_t frmBit = 0;          ///< next bit in frmByte
+static uint8_t frmCrc = 0;          ///< CRC for the frame so far
+static bool frmStore = false;       ///< the frame received is being stored
+static bool frmAck = false;         ///< the frame received had a good CRC and was stored
+static const uint8_t *frmTx;        ///< buffer for the frame being sent
+
+#define FRM_CRC_BYTES (OPS_CRC ? 1 : 0)  ///< CRC bytes after the frame data
+#endif
+
+static void resetPacket(void)
+// Start of a new transaction
+{
+  rxData = 0;
+  rxBit = txBit = 0;
+  turnaround = false;
+#if OPS_REGS
+  regLeft = 0;
+#endif
+#if OPS_CRC
+  rxCrc = 0;
+  rxAckSlot = txAckWait = txRepeat = false;
+#endif
+#if OPS_FRAMES
+  frmState = FS_NONE;
+#endif
+}
+
+#if OPS_FRAMES
+static void frameStart(void)
+// Frame signal received
+{
+  resetPacket();
+  frmState = FS_START;
+  frmIdx = 0;
+  frmByte = frmBit = 0;
+  frmCrc = 0;
+}
+
+static void frameRxBits(uint8_t value, uint8_t n)
+// Add the bits from a PRI write signal to the frame, storing each 
+// byte as it is completed
+{
+  uint8_t b;
+
+  if (frmState == FS_START)
+  {
+    frmState = FS_RX;
+    frmStore = !rxFrameReady && rxFrameBuf != nullptr;
+  }
+  if (frmState != FS_RX) return;
+
+  frmByte |= (value << frmBit);
+  frmBit += n;
+  if (frmBit < 8) return;
+
+  b = frmByte;
+  frmByte = frmBit = 0;
+  if (frmIdx == 0)              // length
+  {
+    frmLen = b;
+    if (frmLen > rxFrameSize) frmStore = false;
+  }
+  else if (frmIdx <= frmLen)    // data
+  {
+    if (frmStore) rxFrameBuf[frmIdx - 1] = b;
+  }
+  if (frmIdx <= frmLen) frmCrc = opCrc8(frmCrc, b);
+
+  if (++frmIdx > frmLen + FRM_CRC_BYTES)   // complete, b is the CRC byte if used
+  {
+    bool crcOk = (FRM_CRC_BYTES == 0) || (b == frmCrc);
+
+    frmAck = crcOk && frmStore;
+    if (frmAck)
+    {
+      rxFrameLen = frmLen;
+      rxFrameReady = true;
+    }
+    else if (crcOk && rxLost != 0xff)   // good frame with nowhere to put it
+      rxLost++;
+    frmState = OPS_CRC ? FS_RX_ACK : FS_END;
+  }
+}
+
+static void frameTxBit(void)
+// Respond to a PRI read signal in a frame
+{
+  if (frmState == FS_START)   // latch the frame, the first byte is the length
+  {
+    frmState = FS_TX;
+    frmTx = txFrameBuf;
+    frmLen = txFrameLen;
+    frmByte = frmLen;
+  }
+  else if (frmState == FS_RX_ACK)   // ACK is LOW, NAK is left HIGH
+  {
+    frmState = FS_END;
+    if (frmAck) SEC_SIGNAL_LOW(timeRdSignal);
+    return;
+  }
+  if (frmState != FS_TX) return;
+
+  if (((frmByte >> frmBit) & 1) == 0) SEC_SIGNAL_LOW(timeRdSignal);   // a 1 leaves the link HIGH
+  if (++frmBit < 8) return;
+
+  // byte sent, set up the next one
+  frmBit = 0;
+  if (frmIdx <= frmLen) frmCrc = opCrc8(frmCrc, frmByte);
+  frmIdx++;
+  if (frmIdx <= frmLen)
+    frmByte = frmTx[frmIdx - 1];
+  else if (frmIdx <= frmLen + FRM_CRC_BYTES)
+    frmByte = frmCrc;
+  else
+    frmState = FS_END;
+}
+#endif
+
+#if OPS_REGS
+static void regCommand(opPriPacket_t cmd)
+// Carry out a register command packet from PRI
+{
+  uint8_t reg = OPR_CMD_REG(OPS_BPP_PRI, cmd);
+  opPriPacket_t v = OPR_CMD_VALUE(OPS_BPP_PRI, cmd);
+
+  regLeft = 0;
+  switch (OPR_CMD_OP(OPS_BPP_PRI, cmd))
+  {
+  case OPR_WRITE:
+    if (reg < regCount && regTable[reg].writable)
+    {
+      *regTable[reg].value = v;
+      if (regTable[reg].onWrite != nullptr) regTable[reg].onWrite(reg, v);
+    }
+    break;
+
+  case OPR_READ:  regNext = reg; regLeft = 1; break;
+  case OPR_READN: regNext = reg; regLeft = v; break;
+  }
+
+  // the reply is always ready
+  turnaround = true;
+  replyBusy = false;
+}
+
+static opSecPacket_t regValue(void)
+// Next register value sent to PRI, all 1 bits for an unknown register
+{
+  uint8_t reg = regNext++;
+
+  regLeft--;
+  return(reg < regCount ? (opSecPacket_t)*regTable[reg].value : (opSecPacket_t)0xffffffff);
+}
+#endif
+
+static void rxBits(uint8_t value, bool symbol)
+// Add the bit or 2 bit symbol from a PRI write signal to the packet
+{
+  uint8_t n = 1;
+
+#if OPS_FRAMES
+  if (frmState != FS_NONE)
+  {
+    frameRxBits(value, symbol ? 2 : 1);
+    return;
+  }
+#endif
+
+#if OPS_CRC
+  if (txAckWait)    // PRI ACK (1) or NAK (0) for the packet just sent
+  {
+    txRepeat = ((value & 1) == 0);
+    txAckWait = false;
+    return;
+  }
+#endif
+
+  turnaround = false;
+
+  // the last symbol of an odd sized packet only carries 1 bit
+  if (symbol && rxBit != OPS_BPP_PRI - 1 && rxBit != RX_BITS - 1) n = 2;
+
+  if (rxBit < OPS_BPP_PRI)
+    rxData |= ((opPriPacket_t)value << rxBit);
+#if OPS_CRC
+  else
+    rxCrc |= (value << (rxBit - OPS_BPP_PRI));
+#endif
+  rxBit += n;
+
+  if (rxBit >= RX_BITS)
+  {
+#if OPS_CRC
+    rxAck = (rxCrc == opCrc8Packet(rxData, OPS_BPP_PRI));
+    rxAckSlot = true;
+    if (rxAck)
+#endif
+    {
+#if OPS_REGS
+      if (regTable != nullptr && !testFrame)
+        regCommand(rxData);
+      else
+#endif
+      {
+        rxLast = rxData;
+        if (!testFrame) rxPush(rxData);   // test patterns are not application data
+        turnaround = true;
+        if (cmdHandler != nullptr)
+        {
+          replyNext = cmdHandler(rxData);
+          replyNew = true;
+          replyBusy = false;
+        }
+        else
+          replyBusy = true;
+      }
+    }
+    rxData = 0;
+    rxBit = 0;
+#if OPS_CRC
+    rxCrc = 0;
+#endif
+  }
+}
+
+static void txBitSend(void)
+// Respond to a PRI read signal with the next bit
+{
+  bool b;
+
+#if OPS_FRAMES
+  if (frmState != FS_NONE)
+  {
+    frameTxBit();
+    return;
+  }
+#endif
+
+#if OPS_CRC
+  if (rxAckSlot)    // ACK is LOW, NAK is left HIGH
+  {
+    rxAckSlot = false;
+    if (rxAck) SEC_SIGNAL_LOW(timeRdSignal);
+    return;
+  }
+#endif
+
+  if (turnaround)   // LOW while busy, HIGH when the reply is ready
+  {
+    if (replyBusy && !testFrame)
+      SEC_SIGNAL_LOW(timeRdSignal);
+    else
+    {
+      turnaround = false;
+      txBit = 0;
+    }
+    return;
+  }
+
+  if (txBit == 0)   // starting a new packet
+  {
+#if OPS_CRC
+    if (!txRepeat)
+#endif
+    {
+      if (testFrame)
+        txData = (opSecPacket_t)rxLast;
+#if OPS_REGS
+      else if (regLeft != 0)
+        txData = regValue();
+#endif
+      else if (txNextReady)
+      {
+        txData = txLast = txNext;
+        txNextReady = false;
+      }
+      else
+        txData = txPop();
+      if (OPS_BPP_SEC < 32) txData &= (((opSecPacket_t)1 << OPS_BPP_SEC) - 1);
+    }
+  }
+
+#if OPS_CRC
+  if (txBit >= OPS_BPP_SEC)
+    b = (txCrc >> (txBit - OPS_BPP_SEC)) & 1;
+  else
+#endif
+    b = (txData >> txBit) & 1;
+  if (!b) SEC_SIGNAL_LOW(timeRdSignal);   // a 1 leaves the link HIGH
+
+#if OPS_CRC
+  // work out the CRC after the first bit has been sent
+  if (txBit == 0)
+  {
+    txCrc = opCrc8Packet(txData, OPS_BPP_SEC);
+    txRepeat = false;
+  }
+#endif
+
+  if (++txBit >= TX_BITS)
+  {
+    txBit = 0;
+#if OPS_CRC
+    txAckWait = true;
+#endif
+    txPrefetch();
+  }
+}
+
+// The ISR is called on a change to the input.
+// The falling edge is the start of a signal and the time to the
+// rising edge determines the type of signal it is. The SEC response
+// to the signal is completed in the ISR.
+//
+// The pin changes made by the SEC itself also trigger the interrupt,
+// but these always end with the pin HIGH and are ignored while
+// waiting for the start of a new signal.
+void opsISR(void)
+{
+  static bool waitingNewSignal = true;  // idle waiting for a new signal to start
+  static opsTick_t tickStart;           // signal start time
+#if OPS_TRACE
+  static opsTick_t tickEnd = 0;         // previous signal end time
+  opsTick_t gap;
+#endif
+  opsTick_t duration;
+
+  tickLastEdge = OPS_TIMER_NOW();
+  msLastEdge = millis();
+
+  if (waitingNewSignal)
+  {
+    // Waiting for start of signal. This will be a transition from
+    // HIGH to LOW, so check the signal is LOW before starting the timing.
+    if (digitalRead(secPin) == LOW)
+    {
+      tickStart = OPS_TIMER_NOW();
+      waitingNewSignal = false;
+    }
+    return;
+  }
+
+  // Timing the duration of the LOW signal detected earlier.
+  // A LOW here is a missed edge, so keep timing until the pin goes HIGH.
+  if (digitalRead(secPin) == LOW) return;
+  duration = OPS_TIMER_NOW() - tickStart;
+  waitingNewSignal = true;
+#if OPS_TRACE
+  gap = tickStart - tickEnd;
+  tickEnd = tickStart + duration;
+#endif
+
+  // Process the signal based on the duration (in increasing order).
+  // Sync is checked first as it is always at the default timeslot and
+  // the signal after a Sync is always the Reset at the new timeslot.
+  if (duration > OPS_US_TO_TICKS(OPT_SYNC_DETECT))    // Sync signal
+  {
+    TRACE_SIGNAL(OPTR_SYNC);
+    SEC_SIGNAL_LOW(OPT_RST_PRESENCE);
+    resetPacket();
+    syncRcv = true;
+    testFrame = false;
+  }
+  else if (syncRcv)                                   // Reset at the new timeslot
+  {
+    uint16_t t = OPS_TICKS_TO_US(duration) / OPT_RST_SIGNAL_T(1);
+
+    TRACE_SIGNAL(OPTR_RESET);
+    syncRcv = false;
+    if (t >= OPS_OPT_MIN)     // otherwise no presence and keep the current T
+    {
+      setTimeslot(t);
+      SEC_SIGNAL_LOW(timePresence);
+      testFrame = true;
+    }
+  }
+#if OPS_WRITE_2BIT
+  else if (duration <= tickSymDetect[3])              // Write symbol signal
+  {
+    uint8_t sym = 3;
+
+    for (uint8_t i = 0; i < 3; i++)
+      if (duration <= tickSymDetect[i]) { sym = i; break; }
+    TRACE_SIGNAL(OPTR_SYM0 + sym);
+    rxBits(sym, true);
+  }
+#else
+  else if (duration <= tickWr1Detect)                 // Write 1 signal
+  {
+    TRACE_SIGNAL(OPTR_WR1);
+    rxBits(1, false);
+  }
+  else if (duration <= tickWr0Detect)                 // Write 0 signal
+  {
+    TRACE_SIGNAL(OPTR_WR0);
+    rxBits(0, false);
+  }
+#endif
+  else if (duration <= tickRdDetect)                  // Read request
+  {
+    TRACE_SIGNAL(OPTR_READ);
+    txBitSend();
+  }
+#if OPS_FRAMES
+  else if (duration <= tickFrmDetect)                 // Frame signal, SEC does not respond
+  {
+    TRACE_SIGNAL(OPTR_FRAME);
+    frameStart();
+  }
+#endif
+  else                                                // the only thing left is a Reset signal
+  {
+    TRACE_SIGNAL(OPTR_RESET);
+    SEC_SIGNAL_LOW(timePresence);
+    resetPacket();
+    testFrame = false;
+    txPrefetch();
+  }
+}
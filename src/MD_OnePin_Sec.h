@@ -0,0 +1,408 @@
+#pragma once
+
+#include <Arduino.h>
+#include <MD_OnePin_Protocol.h>
+#include <MD_OnePin_SecTimer.h>
+#include <MD_OnePin_Crc.h>
+#include <MD_OnePin_Irq.h>
+#include <MD_OnePin_Trace.h>
+
+/**
+ * \file
+ * \brief Header file for the packaged SEC implementation of the OnePin protocol.
+ *
+ * The SEC implementation is written as 'C' style functions. All the signal
+ * decoding, read responses and presence signals are handled in the pin
+ * ISR, so the link timing does not depend on how busy the SEC application
+ * loop() is. Completed packets received from PRI are delivered to the
+ * application through a small queue.
+ *
+ * As the timing constants in MD_OnePin_Protocol.h are C++ constants this
+ * is compiled as C++, but the interface is plain functions and data.
+ *
+ * Typical use
+ * - Call opsBegin() in setup().
+ * - Call opsAvailable() and opsRead() in loop() to process received packets.
+ * - Call opsSetReply() whenever the data to send to PRI changes, or
+ *   opsQueueReply() to send a sequence of packets.
+ * - Optionally call opsAttention() to tell PRI there is something new.
+ *
+ * \sa \ref pageImplementation
+ */
+
+/**
+\def OPS_BPP_PRI
+The size in bits of the packet received from PRI by this SEC.
+*/
+#ifndef OPS_BPP_PRI
+#define OPS_BPP_PRI BPP_PRI
+#endif
+
+/**
+\def OPS_BPP_SEC
+The size in bits of the packet sent to PRI by this SEC. It cannot be more 
+than BPP_SEC, which sets the size of opSecPacket_t.
+*/
+#ifndef OPS_BPP_SEC
+#define OPS_BPP_SEC BPP_SEC
+#endif
+
+static_assert(OPS_BPP_SEC <= BPP_SEC, "OPS_BPP_SEC is larger than BPP_SEC, so replies will not fit opSecPacket_t");
+
+/**
+\def OPS_WRITE_2BIT
+Set to 1 if PRI writes to this SEC using the 2 bit symbol encoding 
+(MD_OnePin::ENC_2BIT), 0 for the default 1 bit encoding.
+*/
+#ifndef OPS_WRITE_2BIT
+#define OPS_WRITE_2BIT 0
+#endif
+
+/**
+\def OPS_CRC
+Set to 1 if PRI sends and checks a CRC with each packet (MD_OnePin::setCrc()).
+Received packets with a CRC error are NAKed and not queued, and sent 
+packets NAKed by PRI are sent again.
+*/
+#ifndef OPS_CRC
+#define OPS_CRC 0
+#endif
+
+/**
+\def OPS_FRAMES
+Set to 1 to support length-prefixed frames (MD_OnePin::writeFrame() and 
+MD_OnePin::readFrame()), 0 to leave the frame code out. Without frame 
+support a Frame signal is treated as a Reset signal.
+*/
+#ifndef OPS_FRAMES
+#define OPS_FRAMES 1
+#endif
+
+/**
+\def OPS_REGS
+Set to 1 to support the register protocol (MD_OnePinReg on PRI) using a 
+register table set by opsSetRegisters(), 0 to leave the register code out.
+Without a register table the packets are handled as normal.
+*/
+#ifndef OPS_REGS
+#define OPS_REGS 1
+#endif
+
+/**
+\def OPS_TRACE
+Set to 1 to record each signal received from PRI in a trace ring, read 
+with opsTraceRead(). The ISR records the signal as it was classified and 
+the measured LOW time, which can be compared with the detection thresholds
+to find marginal slots. The HIGH time since the previous signal is only
+correct up to the range of the signal timer (eg, 32ms for Timer1).
+*/
+#ifndef OPS_TRACE
+#define OPS_TRACE 0
+#endif
+
+/**
+\def OPS_TRACE_SIZE
+The number of signals kept in the trace ring when OPS_TRACE is enabled.
+This must be a power of 2 and no more than 128.
+*/
+#ifndef OPS_TRACE_SIZE
+#define OPS_TRACE_SIZE 32
+#endif
+
+/**
+\def OPS_RX_QUEUE_SIZE
+The number of received packets that can be queued for the application.
+This must be a power of 2.
+*/
+#ifndef OPS_RX_QUEUE_SIZE
+#define OPS_RX_QUEUE_SIZE 4
+#endif
+
+/**
+\def OPS_TX_QUEUE_SIZE
+The number of replies that can be queued for sending to PRI.
+This must be a power of 2.
+*/
+#ifndef OPS_TX_QUEUE_SIZE
+#define OPS_TX_QUEUE_SIZE 4
+#endif
+
+/**
+\def OPS_OPT_MIN
+The smallest timeslot T, in microseconds, this SEC accepts from PRI.
+Set this to OPT_OD or less for a SEC that is fast enough to support 
+overdrive mode.
+*/
+#ifndef OPS_OPT_MIN
+#define OPS_OPT_MIN (OPT / 4)
+#endif
+
+/**
+ * Command handler function.
+ *
+ * Called from the ISR with each packet received from PRI, returning the
+ * reply to send to PRI. This needs to be short as it runs in the ISR.
+ *
+ * \sa opsSetCommandHandler()
+ *
+ * \param cmd the packet received from PRI.
+ * \return the reply to send to PRI.
+ */
+typedef opSecPacket_t (*opsCommand_t)(opPriPacket_t cmd);
+
+#if OPS_REGS
+/**
+ * Register write notification function.
+ *
+ * Called from the ISR after PRI has written a new value to a register, so 
+ * this needs to be short.
+ *
+ * \sa opsRegister_t
+ *
+ * \param reg   the register number.
+ * \param value the value written.
+ */
+typedef void (*opsRegWrite_t)(uint8_t reg, opPriPacket_t value);
+
+/**
+ * One entry in the register table, the register number is the table index.
+ *
+ * \sa opsSetRegisters()
+ */
+typedef struct
+{
+  volatile opPriPacket_t *value;  ///< the register data
+  bool writable;                  ///< true if PRI can write the register
+  opsRegWrite_t onWrite;          ///< called when PRI writes the register, nullptr for none
+} opsRegister_t;
+#endif
+
+/**
+ * Initialize the SEC link.
+ *
+ * Set up the comms pin and the signal timer. If attachISR is true the
+ * opsISR() function is attached to the pin change interrupt for the pin
+ * using attachInterrupt(), otherwise the application needs to call opsISR()
+ * from its own ISR for a pin change on the comms pin.
+ *
+ * \param pin       the comms pin.
+ * \param attachISR true to attach opsISR() to the pin interrupt (default).
+ */
+void opsBegin(uint8_t pin, bool attachISR = true);
+
+/**
+ * Comms pin change ISR.
+ *
+ * Called on every change (rising and falling edges) of the comms pin.
+ * This decodes the PRI signal and performs all the SEC signaling.
+ */
+void opsISR(void);
+
+/**
+ * Check for received packets.
+ *
+ * The test patterns PRI writes in a test frame (eg, MD_OnePin::negotiate()) 
+ * are not application data, so are not queued.
+ *
+ * \return true if there are received packets waiting to be read.
+ */
+bool opsAvailable(void);
+
+/**
+ * Get the next received packet.
+ *
+ * \return the oldest packet received from PRI, 0 if there are none.
+ */
+opPriPacket_t opsRead(void);
+
+/**
+ * Get the number of received packets lost.
+ *
+ * Packets are lost when the receive queue is full because the application
+ * has not read them quickly enough. Frames that arrive before the last one
+ * is released, or that do not fit the frame buffer, are also counted. The
+ * count stops at 255 and is reset to 0 when it is read.
+ *
+ * \return the number of received packets lost since the last call.
+ */
+uint8_t opsRxLost(void);
+
+/**
+ * Set the data sent to PRI.
+ *
+ * This data is sent in response to PRI read requests when there are no
+ * replies queued with opsQueueReply(), and is repeated until it is
+ * changed. The data is latched at the start of each packet sent to PRI,
+ * so the packet is always sent complete.
+ *
+ * \sa opsQueueReply()
+ *
+ * \param data the data to send in response to PRI read requests.
+ */
+void opsSetReply(opSecPacket_t data);
+
+/**
+ * Queue a packet to send to PRI.
+ *
+ * Queued packets are sent in order, one for each packet read by PRI,
+ * before the data set with opsSetReply(). When the queue empties the last
+ * packet sent is repeated until more are queued or opsSetReply() is called.
+ *
+ * The next queued packet is pre-fetched into the send register at each 
+ * Reset and at the end of each packet sent, which also frees its queue 
+ * slot. An application that keeps the queue filled can be read as a 
+ * continuous stream with MD_OnePin::readStream().
+ *
+ * \sa opsSetReply(), MD_OnePin::readStream()
+ *
+ * \param data the packet to send.
+ * \return true if the packet was queued, false if the queue is full.
+ */
+bool opsQueueReply(opSecPacket_t data);
+
+#if OPS_REGS
+/**
+ * Set the register table.
+ *
+ * Packets received from PRI are then handled as register commands (see 
+ * "Register Access" in \ref pageLinkSignals), except in a test frame. 
+ * Register reads are sent straight from the register data in the ISR and 
+ * writes are stored in the register data, so register commands are not 
+ * queued for opsRead(). The register data is a variable owned by the 
+ * application, and registers larger than one byte need to be changed with 
+ * interrupts disabled on 8 bit processors.
+ *
+ * \sa opsRegister_t, MD_OnePinReg
+ *
+ * \param table the register table, which needs to remain in scope. nullptr to stop register handling.
+ * \param count the number of registers in the table.
+ */
+void opsSetRegisters(const opsRegister_t *table, uint8_t count);
+#endif
+
+/**
+ * Set the command handler.
+ *
+ * When PRI uses a write-read transaction (MD_OnePin::transact()) the reply 
+ * is read straight after the command is written. If a command handler is set
+ * it works out the reply in the ISR, so the reply is ready immediately. 
+ * Otherwise SEC signals it is busy until the application calls opsSetReply()
+ * or opsQueueReply() after reading the command with opsRead().
+ *
+ * Received packets are queued for opsRead() as usual.
+ *
+ * \param cb the command handler, nullptr to reply from the application loop().
+ */
+void opsSetCommandHandler(opsCommand_t cb);
+
+#if OPS_FRAMES
+/**
+ * Set the buffer for frames received from PRI.
+ *
+ * The bytes of a frame written by PRI are stored in the buffer as they 
+ * arrive. Frames longer than the buffer are discarded. Once a frame has 
+ * been received opsFrameAvailable() returns true and the buffer is left 
+ * alone until opsFrameDone() is called. Frames received in the meantime 
+ * are lost.
+ *
+ * \sa opsFrameAvailable(), opsFrameDone()
+ *
+ * \param buf  the buffer for received frames, nullptr to ignore frames.
+ * \param size the size of the buffer in bytes.
+ */
+void opsSetRxFrame(uint8_t *buf, uint8_t size);
+
+/**
+ * Check for a received frame.
+ *
+ * \sa opsSetRxFrame(), opsFrameLength()
+ *
+ * \return true if a complete frame is in the frame buffer.
+ */
+bool opsFrameAvailable(void);
+
+/**
+ * Get the length of the received frame.
+ *
+ * \sa opsFrameAvailable()
+ *
+ * \return the number of bytes in the received frame.
+ */
+uint8_t opsFrameLength(void);
+
+/**
+ * Release the frame buffer.
+ *
+ * Called when the application has finished with the received frame so 
+ * that the next frame can be received into the buffer.
+ *
+ * \sa opsSetRxFrame()
+ */
+void opsFrameDone(void);
+
+/**
+ * Set the frame sent to PRI.
+ *
+ * The frame is sent whenever PRI reads a frame. The buffer is read by the
+ * ISR while the frame is sent, so it must stay valid and should not be 
+ * changed during a PRI read. Use two buffers and switch between them to 
+ * change the data safely.
+ *
+ * \param buf the data to send, nullptr to send an empty frame.
+ * \param len the number of bytes to send.
+ */
+void opsSetTxFrame(const uint8_t *buf, uint8_t len);
+#endif
+
+/**
+ * Ask PRI for attention.
+ *
+ * Send an Attention signal to PRI so that it knows SEC has something new, 
+ * rather than PRI having to keep polling. The signal is only sent when the 
+ * link has been idle for long enough that PRI is between transactions, so 
+ * this returns false if the link is busy and needs to be called again later.
+ * The signal takes 2T with interrupts disabled.
+ *
+ * PRI must be in attention mode (MD_OnePin::setAttentionMode()) as 
+ * otherwise it is driving the link HIGH while it is idle.
+ *
+ * \return true if the Attention signal was sent, false if the link is busy.
+ */
+bool opsAttention(void);
+
+/**
+ * Get the current link timeslot.
+ *
+ * \return the timeslot T, in microseconds, set by PRI.
+ */
+uint16_t opsGetTimeslot(void);
+
+#if OPS_TRACE
+/**
+ * Get the number of trace records held.
+ *
+ * \sa opsTraceRead()
+ *
+ * \return the number of records that can be read, up to OPS_TRACE_SIZE.
+ */
+uint8_t opsTraceAvailable(void);
+
+/**
+ * Read the oldest trace record.
+ *
+ * Records are read oldest first and removed from the trace. Interrupts are
+ * only disabled while the one record is copied, so the trace can be read
+ * while PRI is using the link.
+ *
+ * \sa opTrace_t, MD_OnePin_Trace.h
+ *
+ * \param rec the record read.
+ * \return true if a record was read, false if the trace is empty.
+ */
+bool opsTraceRead(opTrace_t &rec);
+
+/**
+ * Remove all the trace records.
+ */
+void opsTraceClear(void);
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+/**
+ * \file
+ * \brief Header for SEC signal timing using a free running hardware timer.
+ *
+ * SEC implementations need to time the LOW part of each PRI signal to
+ * classify it. micros() has a resolution of 4us on 16MHz AVR processors
+ * and turns interrupts off while it runs, which limits how small T can be.
+ *
+ * This header defines macros to use the 16 bit Timer1 of ATmega processors
+ * (eg, ATmega328P, ATmega32U4, ATmega2560) as a free running timebase for
+ * signal timing, giving a resolution of 0.5us at 16MHz. The timer is read
+ * directly in the pin change ISR with OPS_TIMER_NOW().
+ *
+ * Timer1 cannot be used for anything else (eg, Servo library, PWM on the
+ * associated pins) when used for signal timing. millis() and micros() are
+ * not affected.
+ *
+ * OPS_TIMER_AVAILABLE is defined as 1 if the hardware is supported. If it is
+ * 0, the same macros are defined using micros(), so SEC code can be written
+ * to use either.
+ */
+
+#if defined(ARDUINO_ARCH_AVR) && defined(TCNT1H) && defined(TCCR1B)
+#define OPS_TIMER_AVAILABLE 1   ///< 1 if a hardware timer is used for signal timing
+
+typedef uint16_t opsTick_t;     ///< type for a timer value
+
+// Pick the prescaler so that there is a whole number of ticks per microsecond
+#if (F_CPU >= 8000000UL)
+#if (F_CPU % 8000000UL) != 0
+#error MD_OnePin_SecTimer needs F_CPU to be a multiple of 8MHz
+#endif
+#define OPS_TICKS_PER_US (F_CPU / 8000000UL)  ///< timer ticks per microsecond
+#define OPS_TIMER_CS     _BV(CS11)            ///< timer clock select, prescaler 8
+#else
+#define OPS_TICKS_PER_US (F_CPU / 1000000UL)  ///< timer ticks per microsecond
+#define OPS_TIMER_CS     _BV(CS10)            ///< timer clock select, no prescaler
+#endif
+
+/**
+ * Initialize Timer1 as a free running counter.
+ */
+#define OPS_TIMER_BEGIN() do { TCCR1A = 0; TCCR1C = 0; TIMSK1 = 0; TCCR1B = OPS_TIMER_CS; } while (false)
+
+/**
+ * Current timer value in ticks.
+ */
+#define OPS_TIMER_NOW()   ((opsTick_t)TCNT1)
+
+#else
+#define OPS_TIMER_AVAILABLE 0   ///< 1 if a hardware timer is used for signal timing
+
+typedef uint32_t opsTick_t;     ///< type for a timer value
+
+#define OPS_TICKS_PER_US  1     ///< timer ticks per microsecond
+#define OPS_TIMER_BEGIN()
+#define OPS_TIMER_NOW()   ((opsTick_t)micros())
+#endif
+
+/**
+ * Convert microseconds to timer ticks. Use with the OPT_* constants to
+ * work out signal detection thresholds at compile time.
+ */
+#define OPS_US_TO_TICKS(us) ((opsTick_t)((us) * OPS_TICKS_PER_US))
+
+/**
+ * Convert timer ticks to microseconds.
+ */
+#define OPS_TICKS_TO_US(t)  ((t) / OPS_TICKS_PER_US)
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <Arduino.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include <MD_OnePin_Protocol.h>
+
+/**
+ * \file
+ * \brief Header file for the minimal footprint SEC implementation of the OnePin protocol.
+ *
+ * This is a cut down SEC for small AVR processors with a single I/O port,
+ * such as the ATtiny13 and ATtiny25/45/85. It is written to use as little
+ * flash and RAM as possible so that the link fits next to the application
+ * code on 1-8KB devices:
+ * - The pin is read and driven directly through the PORTB registers, and
+ *   the signals are detected with the pin change interrupt, so any PORTB
+ *   pin can be used. pinMode(), digitalWrite() and attachInterrupt() are
+ *   not used.
+ * - Signals are timed by reading the 8 bit Timer0 counter, which runs for
+ *   millis(), so no timer is set up or used up. The signal duration is an
+ *   8 bit tick count, classified against detection thresholds worked out
+ *   from the OPT_*_DETECT values at compile time. micros() is not used.
+ * - The presence and read responses use _delay_us() with constant times.
+ * - The packet variables are the smallest type that fits the packet size.
+ *
+ * All the signaling is done in the ISR. Only the Reset/Presence, Write 0/1
+ * and Read signals are supported, at the fixed timeslot OPT. To PRI it
+ * looks like a legacy SEC, so Sync and Frame signals are treated as Reset
+ * signals and timeslot changes, frames, write-read transactions, 2 bit
+ * symbols and CRC are not available. There is a single packet mailbox
+ * rather than a queue, so a packet not read before the next one arrives
+ * is overwritten.
+ *
+ * Battery powered SEC can set OPST_SLEEP to 1 and call opstSleep() from
+ * loop() to sleep between signals, in idle mode or in power-down with the
+ * link idle. The processor wakes on the pin change at the start of the
+ * next signal. The wake up time is checked against the Reset signal margin
+ * at compile time, and added in the ISR when it is at least one timer tick.
+ *
+ * RAM use is the received and reply packets (in and out of the ISR) plus
+ * 4 bytes (5 with OPST_SLEEP), or 14 bytes with the default packet sizes.
+ * static_assert checks that the link variables add up to this figure and
+ * that the packet types are the smallest that fit. The flash used depends
+ * on the compiler and options, so it is not checked; the IDE build report
+ * for the MD_OnePin_Sec_ATTiny_LED example shows the actual figure.
+ *
+ * This header includes the ISR and its data, so it must only be included
+ * in one file of the application (normally the sketch). The OPST_*
+ * settings are defined before it is included.
+ *
+ * \sa \ref pageImplementation
+ */
+
+/**
+\def OPST_PIN
+The PORTB bit number of the comms pin.
+*/
+#ifndef OPST_PIN
+#define OPST_PIN 2
+#endif
+
+/**
+\def OPST_BPP_PRI
+The size in bits of the packet received from PRI by this SEC.
+*/
+#ifndef OPST_BPP_PRI
+#define OPST_BPP_PRI BPP_PRI
+#endif
+
+/**
+\def OPST_BPP_SEC
+The size in bits of the packet sent to PRI by this SEC.
+*/
+#ifndef OPST_BPP_SEC
+#define OPST_BPP_SEC BPP_SEC
+#endif
+
+/**
+\def OPST_SLEEP
+Set to 1 to include opstSleep() for sleeping between signals, and the
+wake up time compensation in the ISR.
+*/
+#ifndef OPST_SLEEP
+#define OPST_SLEEP 0
+#endif
+
+/**
+\def OPST_WAKE_US
+The time in microseconds from the falling edge of a signal that wakes the
+processor from power-down to the start of timing in the ISR. Timer0 is
+stopped in power-down, so this is added to the first signal after waking.
+The default is the 6 clock start up of the internal RC oscillator plus the
+interrupt response and ISR entry at 8MHz. Only used if OPST_SLEEP is 1.
+
+The time is converted to whole timer ticks, rounding down, so it is only
+added when it is at least one tick. With the default Timer0 at 8&micro;s per
+tick the default wake up time is 0 ticks, as it is less than the timer
+resolution. What makes the wake up safe is the static_assert that it is
+well inside the margin between the Reset signal and the Read detection
+threshold. A longer start up time (eg, a crystal) or a faster timer makes
+the compensation count.
+*/
+#ifndef OPST_WAKE_US
+#define OPST_WAKE_US 4
+#endif
+
+/**
+\def OPST_TIMER_PRESCALE
+The clock prescaler for the timer read by OPST_TIMER_NOW(). The default
+is for Timer0 with the prescaler of 64 set up by the Arduino core for
+millis(), giving 8&micro;s per tick at 8MHz.
+*/
+#ifndef OPST_TIMER_PRESCALE
+#define OPST_TIMER_PRESCALE 64
+#endif
+
+/**
+\def OPST_TIMER_NOW
+Current 8 bit timer count, used to time the signals. Define this and
+OPST_TIMER_PRESCALE to use a different timer.
+*/
+#ifndef OPST_TIMER_NOW
+#define OPST_TIMER_NOW() ((uint8_t)TCNT0)
+#endif
+
+#if OPST_SLEEP
+#include <avr/sleep.h>
+#endif
+
+#if !defined(PCMSK) || !defined(PCIE) || !defined(PORTB)
+#error MD_OnePin_SecTiny needs an AVR processor with a single pin change interrupt on PORTB
+#endif
+
+/// Convert microseconds to 8 bit timer ticks at compile time
+#define OPST_TICKS(us) ((uint8_t)(((uint32_t)(us) * (F_CPU / OPST_TIMER_PRESCALE)) / 1000000UL))
+
+static_assert(((uint32_t)OPT_WR1_DETECT * (F_CPU / OPST_TIMER_PRESCALE)) / 1000000UL >= 4, 
+  "The timer is too slow to time signals at the timeslot OPT");
+static_assert(!OPST_SLEEP || OPST_WAKE_US < OPT_RST_SIGNAL - OPT_RD_DETECT, 
+  "The wake up time from power-down is too long for the Reset signal");
+static_assert(((uint32_t)OPT_SYNC_SIGNAL * (F_CPU / OPST_TIMER_PRESCALE)) / 1000000UL < 256, 
+  "The timer is too fast to time signals in 8 bits");
+
+/**
+ * Packet type received from PRI, the smallest type that fits OPST_BPP_PRI bits.
+ */
+#if (OPST_BPP_PRI <= 8)
+typedef uint8_t opstRxPacket_t;
+#elif (OPST_BPP_PRI <= 16)
+typedef uint16_t opstRxPacket_t;
+#else
+typedef uint32_t opstRxPacket_t;
+#endif
+
+/**
+ * Packet type sent to PRI, the smallest type that fits OPST_BPP_SEC bits.
+ */
+#if (OPST_BPP_SEC <= 8)
+typedef uint8_t opstTxPacket_t;
+#elif (OPST_BPP_SEC <= 16)
+typedef uint16_t opstTxPacket_t;
+#else
+typedef uint32_t opstTxPacket_t;
+#endif
+
+// ---- Direct register I/O for the comms pin
+#define OPST_MASK      _BV(OPST_PIN)                                    ///< comms pin bit mask
+#define OPST_IS_LOW    ((PINB & OPST_MASK) == 0)                        ///< true if the link is LOW
+#define OPST_SET_INPUT do { DDRB &= ~OPST_MASK; PORTB |= OPST_MASK; } while (false)  ///< release the link, with pullup
+
+/// Pull the link LOW for the constant time in microseconds, then release it
+#define OPST_SIGNAL_LOW(us) do { PORTB &= ~OPST_MASK; DDRB |= OPST_MASK; _delay_us(us); OPST_SET_INPUT; } while (false)
+
+// ---- Packet data shared ISR/main code
+static volatile opstRxPacket_t opstRxMail;  ///< last packet received from PRI
+static volatile bool opstRxNew = false;     ///< opstRxMail has not been read
+static volatile opstTxPacket_t opstTxMail;  ///< data sent to PRI
+static volatile bool opstWaitSignal = true; ///< ISR is idle waiting for a new signal to start
+#if OPST_SLEEP
+static volatile bool opstWake = false;      ///< processor is in or just out of power-down
+#endif
+
+// ---- Packet state, only used by the ISR
+static uint8_t opstTickStart;               ///< signal start time
+static uint8_t opstBit = 0;                 ///< next bit of the packet
+static opstRxPacket_t opstRxData = 0;       ///< packet being received
+static opstTxPacket_t opstTxData;           ///< packet being sent
+
+// Check the RAM used matches the figure in the file documentation
+static_assert(sizeof(opstRxMail) + sizeof(opstRxNew) + sizeof(opstTxMail) + sizeof(opstWaitSignal) +
+  (OPST_SLEEP ? 1 : 0) + sizeof(opstTickStart) + sizeof(opstBit) + sizeof(opstRxData) + sizeof(opstTxData) ==
+  2 * sizeof(opstRxPacket_t) + 2 * sizeof(opstTxPacket_t) + 4 + (OPST_SLEEP ? 1 : 0),
+  "RAM used is not the packets in and out of the ISR plus 4 bytes");
+static_assert(sizeof(opstRxPacket_t) == (OPST_BPP_PRI <= 8 ? 1 : (OPST_BPP_PRI <= 16 ? 2 : 4)),
+  "opstRxPacket_t is not the smallest type for OPST_BPP_PRI bits");
+static_assert(sizeof(opstTxPacket_t) == (OPST_BPP_SEC <= 8 ? 1 : (OPST_BPP_SEC <= 16 ? 2 : 4)),
+  "opstTxPacket_t is not the smallest type for OPST_BPP_SEC bits");
+
+/**
+ * Initialize the SEC link.
+ *
+ * Set up the comms pin and enable its pin change interrupt. Any other
+ * PORTB pins using the pin change interrupt need to share the ISR.
+ */
+inline void opstBegin(void)
+{
+  OPST_SET_INPUT;
+  PCMSK |= OPST_MASK;
+  GIMSK |= _BV(PCIE);
+}
+
+/**
+ * Check for a received packet.
+ *
+ * \return true if a packet has been received since the last opstRead().
+ */
+inline bool opstAvailable(void)
+{
+  return(opstRxNew);
+}
+
+/**
+ * Get the last received packet.
+ *
+ * \return the last packet received from PRI.
+ */
+inline opstRxPacket_t opstRead(void)
+{
+  opstRxPacket_t data;
+  uint8_t s = SREG;
+
+  cli();    // multi byte value is written by the ISR
+  data = opstRxMail;
+  opstRxNew = false;
+  SREG = s;
+
+  return(data);
+}
+
+/**
+ * Set the data sent to PRI.
+ *
+ * The data is latched at the start of each packet sent to PRI, so the
+ * packet is always sent complete.
+ *
+ * \param data the data to send in response to PRI read requests.
+ */
+inline void opstSetReply(opstTxPacket_t data)
+{
+  uint8_t s = SREG;
+
+  cli();    // multi byte value is read by the ISR
+  opstTxMail = data;
+  SREG = s;
+}
+
+#if OPST_SLEEP
+/**
+ * Sleep until the next interrupt.
+ *
+ * Called from loop() when the application has nothing to do. Any
+ * interrupt wakes the processor, including the comms pin change at the
+ * start of the next signal, and the signal is handled in the ISR before
+ * this returns.
+ *
+ * In SLEEP_MODE_IDLE Timer0 keeps running, so millis() and the signal
+ * timing are not affected and the processor can sleep at any time. The
+ * Timer0 overflow interrupt for millis() wakes it about every 2ms.
+ *
+ * In SLEEP_MODE_PWR_DOWN the clocks stop and only a pin change (or the
+ * watchdog) wakes the processor. Timer0 and millis() do not advance while
+ * asleep, and the time to wake up (OPST_WAKE_US) is added to the signal
+ * that wakes the processor. The processor only powers down between
+ * signals with the link idle HIGH, otherwise it sleeps in idle mode. The
+ * start up time from power-down set by the fuses needs to be a lot less
+ * than the Reset signal; this is only a few clocks for the internal RC
+ * oscillator.
+ *
+ * \param mode SLEEP_MODE_IDLE or SLEEP_MODE_PWR_DOWN. Defaults to SLEEP_MODE_IDLE.
+ */
+inline void opstSleep(uint8_t mode = SLEEP_MODE_IDLE)
+{
+  cli();    // no signal can start between the check and sleeping
+  if (mode == SLEEP_MODE_PWR_DOWN && (!opstWaitSignal || OPST_IS_LOW))
+    mode = SLEEP_MODE_IDLE;
+  opstWake = (mode == SLEEP_MODE_PWR_DOWN);
+  set_sleep_mode(mode);
+  sleep_enable();
+  sei();    // the instruction after sei() runs before any interrupt
+  sleep_cpu();
+  sleep_disable();
+  opstWake = false;
+}
+#endif
+
+// The ISR is called on a change to the comms pin (and any other pin
+// enabled in PCMSK). The falling edge is the start of a signal and the
+// time to the rising edge determines the type of signal it is. The pin
+// changes made by the SEC itself end with the pin HIGH and are ignored
+// while waiting for the start of a new signal.
+ISR(PCINT0_vect)
+{
+  uint8_t duration;
+
+  if (opstWaitSignal)
+  {
+    if (OPST_IS_LOW)
+    {
+      opstTickStart = OPST_TIMER_NOW();
+#if OPST_SLEEP
+      if (opstWake)   // woken by this signal, count the time waking up
+      {
+        opstTickStart -= OPST_TICKS(OPST_WAKE_US);
+        opstWake = false;
+      }
+#endif
+      opstWaitSignal = false;
+    }
+    return;
+  }
+
+  if (OPST_IS_LOW) return;    // missed edge, keep timing
+  duration = OPST_TIMER_NOW() - opstTickStart;
+  opstWaitSignal = true;
+
+  // Process the signal based on the duration (in increasing order).
+  if (duration <= OPST_TICKS(OPT_WR0_DETECT))         // Write 1 or Write 0 signal
+  {
+    if (duration <= OPST_TICKS(OPT_WR1_DETECT))
+      opstRxData |= ((opstRxPacket_t)1 << opstBit);
+    if (++opstBit >= OPST_BPP_PRI)
+    {
+      opstRxMail = opstRxData;
+      opstRxNew = true;
+      opstRxData = 0;
+      opstBit = 0;
+    }
+  }
+  else if (duration <= OPST_TICKS(OPT_RD_DETECT))     // Read request
+  {
+    if (opstBit == 0) opstTxData = opstTxMail;    // starting a new packet
+    if (((opstTxData >> opstBit) & 1) == 0) OPST_SIGNAL_LOW(OPT_RD0_SIGNAL);  // a 1 leaves the link HIGH
+    if (++opstBit >= OPST_BPP_SEC) opstBit = 0;
+  }
+  else                                                // anything longer is a Reset signal
+  {
+    OPST_SIGNAL_LOW(OPT_RST_PRESENCE);
+    opstRxData = 0;
+    opstBit = 0;
+  }
+}
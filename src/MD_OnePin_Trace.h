@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * \file
+ * \brief Header for the link trace records used by PRI and SEC.
+ *
+ * When tracing is enabled (OP_TRACE for PRI, OPS_TRACE for SEC) each
+ * signal is recorded in a small ring in memory, with the signal type and
+ * the measured LOW and HIGH times. The ring keeps the most recent signals,
+ * so after a failure it holds the slots leading up to it. Recording a
+ * signal is a few instructions and the records are read out later, one at
+ * a time, so the trace does not change the link timing the way Serial
+ * debug output does.
+ *
+ * Comparing the recorded times with the OPT_*_DETECT thresholds for the
+ * signal (eg, a Write 1 LOW time close to OPT_WR1_DETECT) shows the
+ * marginal slots, and how much T can be changed.
+ */
+
+/**
+ * Signal types recorded in a trace.
+ */
+enum opTraceSignal_t : uint8_t
+{
+  OPTR_RESET = 0, ///< Reset/Presence signal
+  OPTR_SYNC,      ///< Sync signal
+  OPTR_FRAME,     ///< Frame signal
+  OPTR_WR0,       ///< Write 0 signal
+  OPTR_WR1,       ///< Write 1 signal
+  OPTR_READ,      ///< Read signal
+  OPTR_SYM0,      ///< 2 bit symbol signal, OPTR_SYM0 + the symbol value (0-3)
+};
+
+#define OPTR_SIGNAL_MASK  0x7f  ///< opTrace_t::type bits for the opTraceSignal_t
+#define OPTR_SAMPLE_HIGH  0x80  ///< opTrace_t::type flag, the link was HIGH when PRI sampled it
+
+/**
+ * One trace record.
+ *
+ * The times are in microseconds and stop at 0xffff.
+ */
+typedef struct
+{
+  uint8_t  type;  ///< the opTraceSignal_t, with OPTR_SAMPLE_HIGH set by PRI if the sample was HIGH
+  uint16_t low;   ///< measured LOW time of the signal
+  uint16_t high;  ///< measured HIGH time since the end of the previous signal
+} opTrace_t;
+
+/**
+ * Limit a measured time to the range of a trace record.
+ *
+ * \param us the time in microseconds.
+ * \return the time, stopping at 0xffff.
+ */
+inline uint16_t opTraceTime(uint32_t us)
+{
+  return(us > 0xffff ? 0xffff : (uint16_t)us);
+}